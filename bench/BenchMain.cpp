@@ -0,0 +1,411 @@
+// TestAppBench: drives the renderer in a tight loop, without the display link throttling it,
+// and reports frame time statistics as text and JSON for regression tracking.
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "RenderContext.hpp"
+#include "Renderer.hpp"
+#include "QuadScene.hpp"
+#include "SpriteBatch.hpp"
+#include "SpriteScene.hpp"
+#include "VertexKernels.hpp"
+#include "RenderTargetPool.hpp"
+#include "ParallelRecorder.hpp"
+#include "FrameStats.hpp"
+#include "GpuProfiler.hpp"
+#include "CpuTracer.hpp"
+
+// Set by CMake from the active configuration
+#ifndef TESTAPP_BUILD_TYPE
+#define TESTAPP_BUILD_TYPE "unknown"
+#endif
+
+namespace {
+
+// Every heap allocation of the process, the steady state frame loop is expected to do none
+std::atomic<uint64_t> g_allocationCount {0};
+
+struct BenchSettings {
+    RenderContextSettings context;
+    uint64_t frameCount = 1000;
+    double seconds = 0.0; // Overrides frameCount when set
+    uint64_t warmupFrameCount = 30;
+    size_t quadCount = 1;
+    size_t drawCount = 1;
+    size_t spriteCount = 0; // Draws the sprite scene instead of quads when set
+    unsigned framesInFlight = FrameRing::DEFAULT_FRAMES_IN_FLIGHT;
+    bool parallelRecording = false;
+    size_t kernelPointCount = 0; // Runs the vertex kernel microbenchmark instead of rendering when set
+    bool renderTargets = false; // Reports the render targets of a deferred frame instead of rendering
+    std::string jsonPath;
+    std::string tracePath;
+};
+
+// Sprites drawn per millisecond of filling and recording the batch on the CPU and of the sprite draws on the GPU
+struct SpriteThroughput {
+    double cpuSpritesPerMs = 0.0;
+    double gpuSpritesPerMs = 0.0; // Zero without timestamp support
+};
+
+// Targets of a deferred frame with bloom at the swapchain extent, passes:
+// 0 gbuffer, 1 lighting, 2 bloom downsample, 3 bloom blur, 4 bloom composite, 5 tonemap, 6 UI over the swapchain image
+void reportRenderTargets(RenderContext& context) {
+    const VkExtent2D extent = context.swapchain().extent();
+    const VkExtent2D halfExtent = {std::max(extent.width / 2, 1u), std::max(extent.height / 2, 1u)};
+    const VkImageUsageFlags sampledColor = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    const VkImageUsageFlags sampledDepth = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    // Never read after the pass, lives in tile memory on GPUs with lazily allocated memory
+    const VkImageUsageFlags transientDepth = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+    
+    RenderTargetPool pool(context.device());
+    pool.request({VK_FORMAT_R8G8B8A8_UNORM, extent, sampledColor}, 0, 1);       // Albedo
+    pool.request({VK_FORMAT_R16G16B16A16_SFLOAT, extent, sampledColor}, 0, 1); // Normals
+    pool.request({VK_FORMAT_D16_UNORM, extent, sampledDepth}, 0, 1);          // Depth
+    pool.request({VK_FORMAT_R16G16B16A16_SFLOAT, extent, sampledColor}, 1, 5); // HDR color
+    pool.request({VK_FORMAT_R16G16B16A16_SFLOAT, halfExtent, sampledColor}, 2, 3);
+    pool.request({VK_FORMAT_R16G16B16A16_SFLOAT, halfExtent, sampledColor}, 3, 4);
+    pool.request({VK_FORMAT_R16G16B16A16_SFLOAT, halfExtent, sampledColor}, 4, 5);
+    pool.request({VK_FORMAT_D16_UNORM, extent, transientDepth}, 6, 6);        // UI depth
+    pool.build();
+    
+    printRenderTargetStats(std::cout, pool.stats());
+}
+
+// Single threaded, so the numbers are throughput of one core
+void benchmarkVertexKernels(size_t pointCount) {
+    std::vector<Vec2> points(pointCount);
+    std::vector<Vec3> colors(pointCount, Vec3 {1.0f, 0.5f, 0.25f});
+    std::vector<Vec2> transformed(pointCount);
+    std::vector<Vertex> vertices(pointCount);
+    for (size_t i = 0; i < pointCount; ++i)
+        points[i] = {float(i % 1000), float(i / 1000)};
+    const Affine2D transform {0.8f, -0.6f, 0.6f, 0.8f, 12.5f, -3.25f};
+    const unsigned iterationCount = 20;
+    
+    auto measure = [&](auto func) {
+        std::vector<double> times;
+        for (unsigned i = 0; i < iterationCount; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            func();
+            times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        std::sort(times.begin(), times.end());
+        return pointCount / times[times.size() / 2] / 1000.0; // Million points per second
+    };
+    
+    std::cout << "Vertex kernels, " << pointCount << " points, million points per second on one core"
+              << " (selected: " << vertexKernels().name << "):" << std::endl;
+    for (const auto* kernels : availableVertexKernels()) {
+        volatile float aabbSink = 0.0f; // Keeps the AABB from being optimized away
+        const double transformRate = measure([&]() {
+            kernels->transformPoints(transform, points.data(), transformed.data(), pointCount);
+        });
+        const double packRate = measure([&]() {
+            kernels->packVertices(points.data(), colors.data(), vertices.data(), pointCount);
+        });
+        const double aabbRate = measure([&]() {
+            aabbSink = kernels->computeAabb(points.data(), pointCount).max.x;
+        });
+        std::cout << '\t' << kernels->name << ": transform " << transformRate << ", pack " << packRate
+                  << ", aabb " << aabbRate << std::endl;
+    }
+}
+
+BenchSettings parseArguments(int argc, char* argv[]) {
+    BenchSettings settings;
+    // Display refresh would throttle a window, benchmarks present headless unless asked otherwise
+    settings.context.platform.headless = true;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            settings.frameCount = std::stoull(argv[++i]);
+        else if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+            settings.seconds = std::stod(argv[++i]);
+        else if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc)
+            settings.warmupFrameCount = std::stoull(argv[++i]);
+        else if (std::strcmp(argv[i], "--quads") == 0 && i + 1 < argc)
+            settings.quadCount = std::stoull(argv[++i]);
+        else if (std::strcmp(argv[i], "--draws") == 0 && i + 1 < argc)
+            settings.drawCount = std::stoull(argv[++i]);
+        else if (std::strcmp(argv[i], "--sprites") == 0 && i + 1 < argc)
+            settings.spriteCount = std::stoull(argv[++i]);
+        else if (std::strcmp(argv[i], "--kernels") == 0 && i + 1 < argc)
+            settings.kernelPointCount = std::stoull(argv[++i]);
+        else if (std::strcmp(argv[i], "--render-targets") == 0)
+            settings.renderTargets = true;
+        else if (std::strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc)
+            settings.framesInFlight = static_cast<unsigned>(std::stoul(argv[++i]));
+        else if (std::strcmp(argv[i], "--parallel-recording") == 0)
+            settings.parallelRecording = true;
+        else if (std::strcmp(argv[i], "--window") == 0)
+            settings.context.platform.headless = false;
+        else if (std::strcmp(argv[i], "--cold-pipeline-cache") == 0)
+            settings.context.coldPipelineCache = true;
+        else if (std::strcmp(argv[i], "--validation") == 0)
+            settings.context.validation = true;
+        else if (std::strcmp(argv[i], "--no-validation") == 0)
+            settings.context.validation = false;
+        else if (std::strcmp(argv[i], "--gpu") == 0 && i + 1 < argc)
+            settings.context.gpu = argv[++i];
+        else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            settings.jsonPath = argv[++i];
+        else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+            settings.tracePath = argv[++i];
+    }
+    return settings;
+}
+
+void writeJson(std::ostream& stream,
+               const BenchSettings& settings,
+               const RenderContext& context,
+               const FrameTimeSummary& summary,
+               const GpuProfiler& gpuProfiler,
+               const SpriteThroughput& sprites,
+               double allocationsPerFrame) {
+    stream << "{"
+           << "\"device\": \"" << context.physicalDevice().getProperties().deviceName << "\""
+           << ", \"quads\": " << settings.quadCount
+           << ", \"draws\": " << settings.drawCount
+           << ", \"framesInFlight\": " << settings.framesInFlight
+           << ", \"parallelRecording\": " << (settings.parallelRecording ? "true" : "false")
+           << ", \"buildType\": \"" << TESTAPP_BUILD_TYPE << "\""
+           << ", \"validation\": " << (context.validation() ? "true" : "false")
+           << ", \"allocationsPerFrame\": " << allocationsPerFrame
+           << ", \"summary\": ";
+    writeFrameTimeSummaryJson(stream, summary);
+    // Empty when the graphics queue has no timestamp support
+    stream << ", \"gpuScopes\": [";
+    const auto& timings = gpuProfiler.timings();
+    for (size_t i = 0; i < timings.size(); ++i) {
+        stream << (i > 0 ? ", " : "")
+               << "{\"name\": \"" << timings[i].name << "\""
+               << ", \"averageMs\": " << timings[i].averageMilliseconds
+               << ", \"lastMs\": " << timings[i].lastMilliseconds << "}";
+    }
+    stream << "]";
+    if (settings.spriteCount > 0) {
+        stream << ", \"sprites\": {\"count\": " << settings.spriteCount
+               << ", \"cpuSpritesPerMs\": " << sprites.cpuSpritesPerMs
+               << ", \"gpuSpritesPerMs\": " << sprites.gpuSpritesPerMs << "}";
+    }
+    // Validation stays on in soak runs, its cost shows up here rather than as console output
+    if (const auto* debugMessages = context.debugMessages()) {
+        stream << ", \"debugMessages\": {"
+               << "\"errors\": " << debugMessages->messageCount(VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
+               << ", \"warnings\": " << debugMessages->messageCount(VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT)
+               << ", \"dropped\": " << debugMessages->droppedCount() << "}";
+    }
+    stream << "}" << std::endl;
+}
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    ++g_allocationCount;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+int main(int argc, char* argv[]) {
+    auto settings = parseArguments(argc, argv);
+    
+    if (settings.kernelPointCount > 0) {
+        benchmarkVertexKernels(settings.kernelPointCount);
+        return EXIT_SUCCESS;
+    }
+    
+    CpuTraceSession traceSession(settings.tracePath);
+    
+    // Frames are driven from this loop, platform callbacks stay unused
+    RenderContext context(settings.context, nullptr, nullptr);
+    const auto& device = context.device();
+    
+    if (settings.renderTargets) {
+        reportRenderTargets(context);
+        return EXIT_SUCCESS;
+    }
+    
+    QuadScene scene(device, context.uploadQueue(), settings.quadCount);
+    
+    PipelineDesc pipelineDesc;
+    pipelineDesc.vertexShader = context.shaderLibrary().get("vert.spv")->module();
+    pipelineDesc.fragmentShader = context.shaderLibrary().get("frag.spv")->module();
+    scene.fillPipelineDesc(pipelineDesc);
+    pipelineDesc.layout = context.pipelineLayout();
+    pipelineDesc.renderPass = context.renderPass();
+    auto pipeline = context.pipelineRegistry().get(pipelineDesc);
+    
+    std::unique_ptr<StreamingRingBuffer> spriteStream;
+    std::unique_ptr<SpriteBatch> spriteBatch;
+    std::unique_ptr<SpriteScene> spriteScene;
+    VkPipeline spritePipeline = VK_NULL_HANDLE;
+    if (settings.spriteCount > 0) {
+        // Room for every frame in flight plus the one being recorded, and the padding of one wrap
+        spriteStream = std::make_unique<StreamingRingBuffer>(device,
+                                                             sizeof(SpriteInstance) * settings.spriteCount * (settings.framesInFlight + 1),
+                                                             VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                                             settings.framesInFlight);
+        spriteBatch = std::make_unique<SpriteBatch>(device, context.uploadQueue(), *spriteStream);
+        spriteScene = std::make_unique<SpriteScene>(settings.spriteCount);
+        PipelineDesc spritePipelineDesc = pipelineDesc;
+        spritePipelineDesc.vertexShader = context.shaderLibrary().get("sprite_vert.spv")->module();
+        spritePipelineDesc.fragmentShader = context.shaderLibrary().get("sprite_frag.spv")->module();
+        spriteBatch->fillPipelineDesc(spritePipelineDesc);
+        spritePipeline = context.pipelineRegistry().get(spritePipelineDesc);
+    }
+    
+    std::unique_ptr<ParallelRecorder> parallelRecorder;
+    if (settings.parallelRecording)
+        parallelRecorder = std::make_unique<ParallelRecorder>(device,
+                                                              device.physicalDevice().queueFamilies().graphicsFamily,
+                                                              settings.framesInFlight,
+                                                              &context.jobSystem());
+    
+    GpuProfiler gpuProfiler(device, device.physicalDevice().queueFamilies().graphicsFamily, settings.framesInFlight);
+    
+    const VkRenderPass renderPass = context.renderPass();
+    const size_t drawCount = settings.drawCount;
+    uint64_t spriteFrameCount = 0;
+    double spriteCpuMilliseconds = 0.0; // Filling and recording the batch, reset after warmup
+    auto recordFunc = [&](VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, const VkExtent2D& extent, unsigned frameIndex) {
+        gpuProfiler.beginFrame(commandBuffer, frameIndex);
+        GpuScope scope(&gpuProfiler, commandBuffer, "main pass");
+        if (spriteBatch != nullptr) {
+            beginRenderPass(commandBuffer, renderPass, framebuffer, extent, VK_SUBPASS_CONTENTS_INLINE);
+            // Fixed time step keeps the animation identical between runs
+            const auto spriteStart = std::chrono::steady_clock::now();
+            spriteStream->beginFrame(frameIndex);
+            spriteBatch->begin();
+            spriteScene->update(*spriteBatch, spritePipeline, spriteFrameCount++ / 60.0f);
+            {
+                GpuScope spriteScope(&gpuProfiler, commandBuffer, "sprites");
+                spriteBatch->record(commandBuffer, extent);
+            }
+            spriteStream->endFrame();
+            spriteCpuMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - spriteStart).count();
+        } else if (parallelRecorder != nullptr) {
+            parallelRecorder->reset(frameIndex);
+            beginRenderPass(commandBuffer, renderPass, framebuffer, extent, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+            const size_t drawsPerBuffer = std::max<size_t>(drawCount / (parallelRecorder->threadCount() * 4), 1);
+            parallelRecorder->record(commandBuffer, frameIndex, renderPass, 0, framebuffer, drawCount, drawsPerBuffer,
+                                     [&](VkCommandBuffer secondary, size_t begin, size_t end) {
+                scene.record(secondary, pipeline, extent, begin, end, drawCount);
+            });
+        } else {
+            beginRenderPass(commandBuffer, renderPass, framebuffer, extent, VK_SUBPASS_CONTENTS_INLINE);
+            scene.record(commandBuffer, pipeline, extent, 0, drawCount, drawCount);
+        }
+        vkCmdEndRenderPass(commandBuffer);
+    };
+    
+    Renderer renderer(device,
+                      context.swapchain(),
+                      recordFunc,
+                      settings.framesInFlight,
+                      context.graphicsTimeline(),
+                      context.presentTimeline());
+    context.uploadQueue().wait(scene.uploadTicket());
+    if (spriteBatch != nullptr)
+        context.uploadQueue().wait(spriteBatch->uploadTicket());
+    
+    using Clock = std::chrono::steady_clock;
+    
+    // Pipelines, pools and command buffers reach their steady state during warmup
+    const auto warmupStart = Clock::now();
+    for (uint64_t i = 0; i < settings.warmupFrameCount; ++i)
+        renderer.drawFrame();
+    const double warmupSeconds = std::chrono::duration<double>(Clock::now() - warmupStart).count();
+    spriteCpuMilliseconds = 0.0;
+    
+    // Timed runs reserve for four times the warmup frame rate, so storing frame times doesn't allocate
+    size_t expectedFrameCount = settings.frameCount;
+    if (settings.seconds > 0.0) {
+        const double warmupFramesPerSecond = warmupSeconds > 0.0 ? settings.warmupFrameCount / warmupSeconds : 0.0;
+        expectedFrameCount = static_cast<size_t>(std::max(warmupFramesPerSecond, 1000.0) * settings.seconds * 4.0);
+    }
+    FrameStats stats(expectedFrameCount);
+    const auto benchStart = Clock::now();
+    // Only drawFrame() is counted, the loop around it is bench bookkeeping
+    uint64_t allocations = 0;
+    while (true) {
+        if (settings.seconds > 0.0) {
+            if (std::chrono::duration<double>(Clock::now() - benchStart).count() >= settings.seconds)
+                break;
+        } else if (stats.frameCount() >= settings.frameCount) {
+            break;
+        }
+        auto frameStart = Clock::now();
+        const auto allocationsBefore = g_allocationCount.load();
+        renderer.drawFrame();
+        allocations += g_allocationCount.load() - allocationsBefore;
+        stats.addFrame(std::chrono::duration<double, std::milli>(Clock::now() - frameStart).count());
+    }
+    
+    auto summary = stats.summary();
+    const double allocationsPerFrame = summary.frameCount > 0 ? double(allocations) / summary.frameCount : 0.0;
+    if (spriteBatch != nullptr) {
+        std::cout << "Scene: " << settings.spriteCount << " sprites in " << spriteBatch->batchCount() << " batches" << std::endl;
+    } else {
+        std::cout << "Scene: " << settings.quadCount << " quads in " << settings.drawCount << " draws"
+                  << (settings.parallelRecording ? ", parallel recording" : "") << std::endl;
+    }
+    printFrameTimeSummary(std::cout, summary);
+    printGpuTimings(std::cout, gpuProfiler);
+    
+    SpriteThroughput spriteThroughput;
+    if (spriteBatch != nullptr && summary.frameCount > 0) {
+        const double spritesDrawn = double(settings.spriteCount) * summary.frameCount;
+        if (spriteCpuMilliseconds > 0.0)
+            spriteThroughput.cpuSpritesPerMs = spritesDrawn / spriteCpuMilliseconds;
+        for (const auto& timing : gpuProfiler.timings()) {
+            if (timing.name == "sprites" && timing.averageMilliseconds > 0.0)
+                spriteThroughput.gpuSpritesPerMs = settings.spriteCount / timing.averageMilliseconds;
+        }
+        std::cout << "Sprites per ms: CPU " << spriteThroughput.cpuSpritesPerMs
+                  << ", GPU " << spriteThroughput.gpuSpritesPerMs << std::endl;
+    }
+    std::cout << "Heap allocations per frame: " << allocationsPerFrame << std::endl;
+    std::cout << "Build: " << TESTAPP_BUILD_TYPE << ", validation " << (context.validation() ? "on" : "off") << std::endl;
+    if (auto* debugMessages = context.debugMessages()) {
+        debugMessages->flush();
+        if (!debugMessages->counters().empty() || debugMessages->droppedCount() > 0)
+            printDebugMessageCounters(std::cout, *debugMessages);
+    }
+    
+    if (!settings.jsonPath.empty()) {
+        std::ofstream jsonFile(settings.jsonPath);
+        if (!jsonFile)
+            throw std::runtime_error("Can't open " + settings.jsonPath);
+        writeJson(jsonFile, settings, context, summary, gpuProfiler, spriteThroughput, allocationsPerFrame);
+    } else {
+        writeJson(std::cout, settings, context, summary, gpuProfiler, spriteThroughput, allocationsPerFrame);
+    }
+    
+    // Job submission allocates and validation layers allocate through the same operator new,
+    // every other configuration has to draw its steady state frames without touching the heap
+    if (!settings.parallelRecording && !context.validation() && allocations > 0) {
+        std::cout << "Steady state frames allocated " << allocations << " times" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,28 @@
+#!/bin/sh
+# Builds TestAppBench in every shipping configuration and compares CPU frame time.
+# Extra arguments go to every TestAppBench run, e.g. ./bench_configurations.sh --quads 10000 --draws 100
+set -e
+
+BUILD_ROOT=_bench_build
+REPORT_DIR=$BUILD_ROOT/reports
+mkdir -p $REPORT_DIR
+
+# run <report name> <CMAKE_BUILD_TYPE> <TESTAPP_VALIDATION> [TestAppBench arguments]
+run() {
+    NAME=$1
+    BUILD_DIR=$BUILD_ROOT/$2-$3
+    cmake -S . -B $BUILD_DIR -DCMAKE_BUILD_TYPE=$2 -DTESTAPP_VALIDATION=$3 > /dev/null
+    cmake --build $BUILD_DIR --target TestAppBench -j > /dev/null
+    shift 3
+    $BUILD_DIR/TestAppBench "$@" --json $REPORT_DIR/$NAME.json > $REPORT_DIR/$NAME.txt
+    MEAN=$(sed -n 's/.*"mean": \([0-9.e+-]*\).*/\1/p' $REPORT_DIR/$NAME.json)
+    P99=$(sed -n 's/.*"p99": \([0-9.e+-]*\).*/\1/p' $REPORT_DIR/$NAME.json)
+    printf "%-28s mean %10s ms   p99 %10s ms\n" "$NAME" "$MEAN" "$P99"
+}
+
+run debug-validation Debug ON --validation "$@"
+run debug Debug ON --no-validation "$@"
+run relwithdebinfo-validation RelWithDebInfo ON --validation "$@"
+run relwithdebinfo RelWithDebInfo ON --no-validation "$@"
+run release-compiled-out Release OFF "$@"
+echo "Reports are in $REPORT_DIR"
@@ -2,4 +2,6 @@
 pushd shaders
 $VULKAN_SDK/bin/glslangValidator -V shader.vert
 $VULKAN_SDK/bin/glslangValidator -V shader.frag
+$VULKAN_SDK/bin/glslangValidator -V sprite.vert -o sprite_vert.spv
+$VULKAN_SDK/bin/glslangValidator -V sprite.frag -o sprite_frag.spv
 popd
@@ -0,0 +1,20 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// Corner of the unit quad centered at the origin, per vertex
+layout(location = 0) in vec2 inCorner;
+// Per instance
+layout(location = 1) in vec4 inTransform; // Columns of a 2x2 matrix, rotation and size
+layout(location = 2) in vec2 inPosition;
+layout(location = 3) in vec4 inColor;
+layout(location = 4) in vec4 inUvRect;    // Offset in xy, size in zw
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec2 fragUv;
+
+void main() {
+    vec2 position = inPosition + inTransform.xy * inCorner.x + inTransform.zw * inCorner.y;
+    gl_Position = vec4(position, 0.0, 1.0);
+    fragColor = inColor;
+    fragUv = inUvRect.xy + inUvRect.zw * (inCorner + 0.5);
+}
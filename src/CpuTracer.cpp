@@ -0,0 +1,166 @@
+#include "CpuTracer.hpp"
+
+#include <iostream>
+
+#if TESTAPP_TRACING
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    uint64_t beginTime;
+    uint64_t endTime;
+};
+
+struct ThreadBuffer {
+    unsigned threadId = 0;
+    const char* threadName = nullptr;
+    // Allocated by the first zone recorded on the thread, threads that never record while tracing don't pay for it
+    std::unique_ptr<TraceEvent[]> events;
+    std::atomic<size_t> eventCount {0}; // Written by the owning thread only
+    std::atomic<size_t> droppedCount {0};
+};
+
+// Buffers outlive their threads, so zones of finished workers still make it into the trace
+struct ThreadRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    uint64_t sessionBeginTime = 0;
+};
+
+ThreadRegistry& registry() {
+    static ThreadRegistry instance;
+    return instance;
+}
+
+thread_local ThreadBuffer* t_buffer = nullptr;
+
+ThreadBuffer& threadBuffer() {
+    if (t_buffer == nullptr) {
+        auto& threads = registry();
+        std::lock_guard<std::mutex> lock(threads.mutex);
+        threads.buffers.push_back(std::make_unique<ThreadBuffer>());
+        t_buffer = threads.buffers.back().get();
+        t_buffer->threadId = static_cast<unsigned>(threads.buffers.size());
+    }
+    return *t_buffer;
+}
+
+} // namespace
+
+std::atomic<bool> CpuTracer::s_recording {false};
+
+void CpuTracer::beginSession() {
+    auto& threads = registry();
+    {
+        std::lock_guard<std::mutex> lock(threads.mutex);
+        for (auto& buffer : threads.buffers) {
+            buffer->eventCount.store(0, std::memory_order_relaxed);
+            buffer->droppedCount.store(0, std::memory_order_relaxed);
+        }
+        threads.sessionBeginTime = now();
+    }
+    if (threadBuffer().threadName == nullptr)
+        setThreadName("main");
+    s_recording.store(true, std::memory_order_release);
+}
+
+bool CpuTracer::endSession(const std::string& path) {
+    s_recording.store(false, std::memory_order_release);
+    
+    std::ofstream file(path);
+    if (!file)
+        return false;
+    
+    auto& threads = registry();
+    std::lock_guard<std::mutex> lock(threads.mutex);
+    
+    // Complete ("X") events with microsecond timestamps relative to the session start
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool first = true;
+    size_t droppedCount = 0;
+    for (const auto& buffer : threads.buffers) {
+        if (buffer->threadName != nullptr) {
+            file << (first ? "" : ",\n")
+                 << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->threadId
+                 << ", \"args\": {\"name\": \"" << buffer->threadName << "\"}}";
+            first = false;
+        }
+        const size_t eventCount = buffer->eventCount.load(std::memory_order_acquire);
+        for (size_t i = 0; i < eventCount; ++i) {
+            const auto& event = buffer->events[i];
+            if (event.beginTime < threads.sessionBeginTime)
+                continue;
+            file << (first ? "" : ",\n")
+                 << "{\"name\": \"" << event.name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer->threadId
+                 << ", \"ts\": " << double(event.beginTime - threads.sessionBeginTime) / 1000.0
+                 << ", \"dur\": " << double(event.endTime - event.beginTime) / 1000.0 << "}";
+            first = false;
+        }
+        droppedCount += buffer->droppedCount.load(std::memory_order_relaxed);
+    }
+    file << "\n]}\n";
+    
+    if (droppedCount > 0)
+        std::cout << "Trace: " << droppedCount << " zones dropped, thread buffers are full" << std::endl;
+    return static_cast<bool>(file);
+}
+
+void CpuTracer::setThreadName(const char* name) {
+    threadBuffer().threadName = name;
+}
+
+uint64_t CpuTracer::now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void CpuTracer::addZone(const char* name, uint64_t beginTime, uint64_t endTime) {
+    auto& buffer = threadBuffer();
+    const size_t index = buffer.eventCount.load(std::memory_order_relaxed);
+    if (index >= EVENTS_PER_THREAD) {
+        buffer.droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    // Only the owning thread writes the pointer, endSession() reads it after seeing a non-zero count
+    if (buffer.events == nullptr)
+        buffer.events.reset(new TraceEvent[EVENTS_PER_THREAD]);
+    buffer.events[index] = {name, beginTime, endTime};
+    // Publishes the event to endSession()
+    buffer.eventCount.store(index + 1, std::memory_order_release);
+}
+
+CpuTraceSession::CpuTraceSession(std::string path)
+    : m_path(std::move(path))
+{
+    if (!m_path.empty())
+        CpuTracer::beginSession();
+}
+
+CpuTraceSession::~CpuTraceSession() {
+    if (m_path.empty())
+        return;
+    if (CpuTracer::endSession(m_path))
+        std::cout << "Trace written to " << m_path << std::endl;
+    else
+        std::cout << "Can't write trace to " << m_path << std::endl;
+}
+
+#else
+
+CpuTraceSession::CpuTraceSession(std::string path)
+    : m_path(std::move(path))
+{
+    if (!m_path.empty())
+        std::cout << "Tracing is compiled out, configure with -DTESTAPP_TRACING=ON to record " << m_path << std::endl;
+}
+
+CpuTraceSession::~CpuTraceSession() = default;
+
+#endif
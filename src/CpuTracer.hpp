@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Set by the TESTAPP_TRACING CMake option, zones expand to nothing when it is off
+#ifndef TESTAPP_TRACING
+#define TESTAPP_TRACING 0
+#endif
+
+/// Writes a Chrome trace (chrome://tracing, ui.perfetto.dev) for the lifetime of the object when path is not empty.
+/// Zones are only recorded while a session is open.
+class CpuTraceSession {
+public:
+    explicit CpuTraceSession(std::string path);
+
+    CpuTraceSession(const CpuTraceSession&) = delete;
+    CpuTraceSession& operator=(const CpuTraceSession&) = delete;
+
+    ~CpuTraceSession();
+
+private:
+    std::string m_path;
+};
+
+#if TESTAPP_TRACING
+
+/// Every thread appends complete zones to its own fixed size buffer, publishing them with a single
+/// atomic store, so recording a zone never takes a lock. Zones past the buffer capacity are dropped.
+class CpuTracer {
+public:
+    static constexpr size_t EVENTS_PER_THREAD = 64 * 1024;
+
+    // Not meant to be called while zones are open on other threads
+    static void beginSession();
+    static bool endSession(const std::string& path);
+
+    static bool isRecording() { return s_recording.load(std::memory_order_relaxed); }
+    // name has to outlive the session, string literals are expected
+    static void setThreadName(const char* name);
+    // Nanoseconds of a monotonic clock
+    static uint64_t now();
+    static void addZone(const char* name, uint64_t beginTime, uint64_t endTime);
+
+private:
+    static std::atomic<bool> s_recording;
+};
+
+class TraceZone {
+public:
+    explicit TraceZone(const char* name)
+        : m_name(CpuTracer::isRecording() ? name : nullptr)
+        , m_beginTime(m_name != nullptr ? CpuTracer::now() : 0)
+    {
+    }
+
+    TraceZone(const TraceZone&) = delete;
+    TraceZone& operator=(const TraceZone&) = delete;
+
+    ~TraceZone() {
+        if (m_name != nullptr)
+            CpuTracer::addZone(m_name, m_beginTime, CpuTracer::now());
+    }
+
+private:
+    const char* m_name;
+    uint64_t m_beginTime;
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+// Measures the rest of the enclosing block, name must be a string literal
+#define TRACE_ZONE(name) TraceZone TRACE_CONCAT(traceZone, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) CpuTracer::setThreadName(name)
+
+#else
+
+#define TRACE_ZONE(name) ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+
+#endif
@@ -0,0 +1,224 @@
+#include "DebugMessageSink.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+// Messages are handed to the printing thread at this interval, the callback itself never wakes it
+constexpr auto DRAIN_INTERVAL = std::chrono::milliseconds(10);
+
+void copyTruncated(char* destination, size_t capacity, const char* source) {
+    size_t length = 0;
+    if (source != nullptr) {
+        while (length + 1 < capacity && source[length] != '\0') {
+            destination[length] = source[length];
+            ++length;
+        }
+    }
+    destination[length] = '\0';
+}
+
+uint64_t hashText(const char* text) {
+    uint64_t hash = 14695981039346656037ull;
+    for (; *text != '\0'; ++text)
+        hash = (hash ^ static_cast<unsigned char>(*text)) * 1099511628211ull;
+    return hash;
+}
+
+unsigned severityIndex(VkDebugUtilsMessageSeverityFlagBitsEXT severity) {
+    switch (severity) {
+        case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT: return 3;
+        case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT: return 2;
+        case VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT: return 1;
+        default: return 0;
+    }
+}
+
+const char* severityName(VkDebugUtilsMessageSeverityFlagBitsEXT severity) {
+    static const char* names[] = {"verbose", "info", "warning", "error"};
+    return names[severityIndex(severity)];
+}
+
+uint64_t currentMilliseconds() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+DebugMessageSink::DebugMessageSink(std::ostream& stream,
+                                   VkDebugUtilsMessageSeverityFlagBitsEXT printSeverity,
+                                   unsigned maxPrintsPerIdPerSecond)
+    : m_stream(stream)
+    , m_printSeverity(printSeverity)
+    , m_maxPrintsPerIdPerSecond(maxPrintsPerIdPerSecond)
+    , m_slots(new Slot[CAPACITY])
+{
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "Ring capacity must be a power of two");
+    for (size_t i = 0; i < CAPACITY; ++i)
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    
+    m_thread = std::thread(&DebugMessageSink::threadLoop, this);
+}
+
+DebugMessageSink::~DebugMessageSink() {
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_stopping = true;
+    }
+    m_wakeCondition.notify_one();
+    m_thread.join();
+    drain();
+    
+    uint64_t suppressedCount = 0;
+    for (const auto& state : m_states)
+        suppressedCount += state.second.counter.suppressedCount;
+    if (suppressedCount > 0 || droppedCount() > 0)
+        printDebugMessageCounters(m_stream, *this);
+}
+
+void DebugMessageSink::push(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+                            VkDebugUtilsMessageTypeFlagsEXT type,
+                            const VkDebugUtilsMessengerCallbackDataEXT& callbackData) {
+    // Bounded multi-producer ring: a slot is claimed by advancing the enqueue position,
+    // its sequence tells whether the consumer is done with the previous lap
+    Slot* slot;
+    size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+    while (true) {
+        slot = &m_slots[position & (CAPACITY - 1)];
+        const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        const auto difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+        if (difference == 0) {
+            if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                break;
+        } else if (difference < 0) {
+            m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            position = m_enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+    
+    auto& message = slot->message;
+    message.severity = severity;
+    message.type = type;
+    message.idNumber = callbackData.messageIdNumber;
+    copyTruncated(message.idName, MAX_ID_NAME_LENGTH, callbackData.pMessageIdName);
+    copyTruncated(message.text, MAX_MESSAGE_LENGTH, callbackData.pMessage);
+    slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+void DebugMessageSink::flush() {
+    drain();
+}
+
+std::vector<DebugMessageCounter> DebugMessageSink::counters() const {
+    std::vector<DebugMessageCounter> result;
+    {
+        std::lock_guard<std::mutex> lock(m_countersMutex);
+        result.reserve(m_states.size());
+        for (const auto& state : m_states)
+            result.push_back(state.second.counter);
+    }
+    std::sort(result.begin(), result.end(), [](const DebugMessageCounter& a, const DebugMessageCounter& b) {
+        return a.count > b.count;
+    });
+    return result;
+}
+
+uint64_t DebugMessageSink::messageCount(VkDebugUtilsMessageSeverityFlagBitsEXT severity) const {
+    std::lock_guard<std::mutex> lock(m_countersMutex);
+    return m_severityCounts[severityIndex(severity)];
+}
+
+void DebugMessageSink::threadLoop() {
+    std::unique_lock<std::mutex> lock(m_wakeMutex);
+    while (!m_stopping) {
+        lock.unlock();
+        drain();
+        lock.lock();
+        m_wakeCondition.wait_for(lock, DRAIN_INTERVAL, [this]() { return m_stopping; });
+    }
+}
+
+void DebugMessageSink::drain() {
+    std::lock_guard<std::mutex> consumerLock(m_consumerMutex);
+    const uint64_t now = currentMilliseconds();
+    m_output.clear();
+    
+    while (true) {
+        auto& slot = m_slots[m_dequeuePosition & (CAPACITY - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != m_dequeuePosition + 1)
+            break;
+        process(slot.message, now);
+        // Hands the slot back to producers for the next lap
+        slot.sequence.store(m_dequeuePosition + CAPACITY, std::memory_order_release);
+        ++m_dequeuePosition;
+    }
+    
+    // Rate limit windows that ran out report what they swallowed
+    {
+        std::lock_guard<std::mutex> lock(m_countersMutex);
+        for (auto& state : m_states) {
+            auto& idState = state.second;
+            if (idState.suppressedInWindow > 0 && now - idState.windowStart >= 1000) {
+                m_output += "[" + state.first + "] " + std::to_string(idState.suppressedInWindow) + " similar messages suppressed\n";
+                idState.suppressedInWindow = 0;
+            }
+        }
+    }
+    
+    // One write and one flush per drain instead of per message
+    if (!m_output.empty())
+        m_stream << m_output << std::flush;
+}
+
+void DebugMessageSink::process(const Message& message, uint64_t now) {
+    std::lock_guard<std::mutex> lock(m_countersMutex);
+    ++m_severityCounts[severityIndex(message.severity)];
+    
+    auto& idState = m_states[message.idName];
+    auto& counter = idState.counter;
+    if (counter.count == 0) {
+        counter.idName = message.idName;
+        counter.idNumber = message.idNumber;
+    }
+    ++counter.count;
+    counter.maxSeverity = std::max(counter.maxSeverity, message.severity);
+    
+    if (message.severity < m_printSeverity)
+        return;
+    
+    if (now - idState.windowStart >= 1000) {
+        idState.windowStart = now;
+        idState.printedInWindow = 0;
+    }
+    
+    const uint64_t textHash = hashText(message.text);
+    const bool repeated = counter.count > 1 && textHash == idState.lastTextHash;
+    if (repeated || idState.printedInWindow >= m_maxPrintsPerIdPerSecond) {
+        ++counter.suppressedCount;
+        ++idState.suppressedInWindow;
+        return;
+    }
+    
+    idState.lastTextHash = textHash;
+    ++idState.printedInWindow;
+    m_output += severityName(message.severity);
+    m_output += ": ";
+    m_output += message.text;
+    m_output += '\n';
+}
+
+void printDebugMessageCounters(std::ostream& stream, const DebugMessageSink& sink) {
+    stream << "Debug messages by ID";
+    if (sink.droppedCount() > 0)
+        stream << " (" << sink.droppedCount() << " dropped, ring was full)";
+    stream << ":" << std::endl;
+    for (const auto& counter : sink.counters()) {
+        stream << '\t' << (counter.idName.empty() ? "<no id>" : counter.idName) << " (" << counter.idNumber << "): "
+               << counter.count << " " << severityName(counter.maxSeverity) << ", "
+               << counter.suppressedCount << " not printed" << std::endl;
+    }
+}
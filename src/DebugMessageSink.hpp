@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct DebugMessageCounter {
+    std::string idName;
+    int32_t idNumber = 0;
+    VkDebugUtilsMessageSeverityFlagBitsEXT maxSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT;
+    uint64_t count = 0;
+    uint64_t suppressedCount = 0; // Repeats and messages over the rate limit which were counted but not printed
+};
+
+/// Takes validation and debug messages off the driver threads. push() copies the message into a bounded
+/// lock-free ring and returns, a background thread prints them, collapsing repeats of the same message
+/// and limiting how many messages of one ID are printed per second. Counters stay exact regardless.
+class DebugMessageSink {
+public:
+    static constexpr size_t CAPACITY = 256; // Power of two
+    static constexpr size_t MAX_ID_NAME_LENGTH = 64;
+    static constexpr size_t MAX_MESSAGE_LENGTH = 1024; // Longer messages are truncated
+
+    explicit DebugMessageSink(std::ostream& stream,
+                              VkDebugUtilsMessageSeverityFlagBitsEXT printSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT,
+                              unsigned maxPrintsPerIdPerSecond = 5);
+
+    DebugMessageSink(const DebugMessageSink&) = delete;
+    DebugMessageSink& operator=(const DebugMessageSink&) = delete;
+
+    // Prints what is still queued and a summary of suppressed messages
+    ~DebugMessageSink();
+
+    // Safe to call from any thread, including from inside a Vulkan call. Never blocks or allocates,
+    // a message is dropped (and counted) when the ring is full.
+    void push(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+              VkDebugUtilsMessageTypeFlagsEXT type,
+              const VkDebugUtilsMessengerCallbackDataEXT& callbackData);
+
+    // Processes everything pushed so far on the calling thread
+    void flush();
+
+    // Sorted by count, most frequent first
+    std::vector<DebugMessageCounter> counters() const;
+    uint64_t messageCount(VkDebugUtilsMessageSeverityFlagBitsEXT severity) const;
+    uint64_t droppedCount() const { return m_droppedCount.load(std::memory_order_relaxed); }
+
+private:
+    struct Message {
+        VkDebugUtilsMessageSeverityFlagBitsEXT severity;
+        VkDebugUtilsMessageTypeFlagsEXT type;
+        int32_t idNumber;
+        char idName[MAX_ID_NAME_LENGTH];
+        char text[MAX_MESSAGE_LENGTH];
+    };
+
+    struct Slot {
+        std::atomic<size_t> sequence;
+        Message message;
+    };
+
+    struct IdState {
+        DebugMessageCounter counter;
+        uint64_t lastTextHash = 0;
+        uint64_t windowStart = 0; // Milliseconds
+        unsigned printedInWindow = 0;
+        uint64_t suppressedInWindow = 0;
+    };
+
+    std::ostream& m_stream;
+    VkDebugUtilsMessageSeverityFlagBitsEXT m_printSeverity;
+    unsigned m_maxPrintsPerIdPerSecond;
+
+    std::unique_ptr<Slot[]> m_slots;
+    std::atomic<size_t> m_enqueuePosition {0};
+    size_t m_dequeuePosition = 0; // Guarded by m_consumerMutex
+    std::atomic<uint64_t> m_droppedCount {0};
+
+    std::mutex m_consumerMutex; // Only one thread drains the ring at a time
+    mutable std::mutex m_countersMutex;
+    std::unordered_map<std::string, IdState> m_states;
+    uint64_t m_severityCounts[4] = {};
+    std::string m_output; // Reused between drains
+
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCondition;
+    bool m_stopping = false;
+    std::thread m_thread;
+
+    void threadLoop();
+    void drain();
+    void process(const Message& message, uint64_t now);
+};
+
+void printDebugMessageCounters(std::ostream& stream, const DebugMessageSink& sink);
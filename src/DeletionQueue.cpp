@@ -0,0 +1,92 @@
+#include "DeletionQueue.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+DeletionQueue::DeletionQueue(VkDevice device)
+    : m_device(device)
+{
+}
+
+DeletionQueue::~DeletionQueue() {
+    for (auto& entry : m_entries)
+        entry.destroyFunc();
+    for (auto& destroyFunc : m_unstamped)
+        destroyFunc();
+}
+
+void DeletionQueue::stamp(uint64_t submittedValue) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& destroyFunc : m_unstamped)
+        m_entries.push_back({submittedValue, std::move(destroyFunc)});
+    m_unstamped.clear();
+}
+
+void DeletionQueue::collect(uint64_t completedValue) {
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_completedValue = std::max(m_completedValue, completedValue);
+        while (!m_entries.empty() && m_entries.front().value <= m_completedValue) {
+            ready.push_back(std::move(m_entries.front().destroyFunc));
+            m_entries.pop_front();
+        }
+    }
+    // Destroy functions may take other locks (the allocator's), so they run outside of ours
+    for (auto& destroyFunc : ready)
+        destroyFunc();
+}
+
+void DeletionQueue::collectAll() {
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& entry : m_entries)
+            ready.push_back(std::move(entry.destroyFunc));
+        m_entries.clear();
+        ready.insert(ready.end(), std::make_move_iterator(m_unstamped.begin()), std::make_move_iterator(m_unstamped.end()));
+        m_unstamped.clear();
+    }
+    for (auto& destroyFunc : ready)
+        destroyFunc();
+}
+
+void DeletionQueue::release(std::function<void()> destroyFunc) {
+    // Work being recorded right now may use the object, so it waits for the next submission even when
+    // everything submitted so far has completed
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_unstamped.push_back(std::move(destroyFunc));
+}
+
+void DeletionQueue::destroyBuffer(VkBuffer buffer) {
+    release([device = m_device, buffer]() { vkDestroyBuffer(device, buffer, nullptr); });
+}
+
+void DeletionQueue::destroyImage(VkImage image) {
+    release([device = m_device, image]() { vkDestroyImage(device, image, nullptr); });
+}
+
+void DeletionQueue::destroyImageView(VkImageView imageView) {
+    release([device = m_device, imageView]() { vkDestroyImageView(device, imageView, nullptr); });
+}
+
+void DeletionQueue::destroyFramebuffer(VkFramebuffer framebuffer) {
+    release([device = m_device, framebuffer]() { vkDestroyFramebuffer(device, framebuffer, nullptr); });
+}
+
+void DeletionQueue::destroyPipeline(VkPipeline pipeline) {
+    release([device = m_device, pipeline]() { vkDestroyPipeline(device, pipeline, nullptr); });
+}
+
+void DeletionQueue::destroySemaphore(VkSemaphore semaphore) {
+    release([device = m_device, semaphore]() { vkDestroySemaphore(device, semaphore, nullptr); });
+}
+
+void DeletionQueue::freeMemory(VkMemoryAllocator& allocator, const MemoryAllocation& allocation) {
+    release([&allocator, allocation]() { allocator.free(allocation); });
+}
+
+size_t DeletionQueue::pendingCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size() + m_unstamped.size();
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "VkMemoryAllocator.hpp"
+
+/// Destroys Vulkan objects once the GPU work that may still use them has completed, so they can be
+/// released in the middle of a frame without idling the device. Work is identified by values of the
+/// graphics QueueTimeline, which outlives renderers and swapchains. Released objects wait for the next
+/// submission: stamp() assigns them its value, and the first collect() with a completed value of at least
+/// that destroys them. Thread safe, destroy functions run on the thread calling collect().
+class DeletionQueue {
+public:
+    explicit DeletionQueue(VkDevice device);
+
+    DeletionQueue(const DeletionQueue&) = delete;
+    DeletionQueue& operator=(const DeletionQueue&) = delete;
+
+    // Destroys what is left, the device has to be idle by then
+    ~DeletionQueue();
+
+    // Work with submittedValue was just submitted, it is the last that may use what was released so far
+    void stamp(uint64_t submittedValue);
+    // Everything up to completedValue has finished on the GPU
+    void collect(uint64_t completedValue);
+    // Nothing is executing anymore, e.g. after waiting for the timeline, destroys stamped and unstamped objects
+    void collectAll();
+
+    void release(std::function<void()> destroyFunc);
+    void destroyBuffer(VkBuffer buffer);
+    void destroyImage(VkImage image);
+    void destroyImageView(VkImageView imageView);
+    void destroyFramebuffer(VkFramebuffer framebuffer);
+    void destroyPipeline(VkPipeline pipeline);
+    void destroySemaphore(VkSemaphore semaphore);
+    void freeMemory(VkMemoryAllocator& allocator, const MemoryAllocation& allocation);
+
+    size_t pendingCount() const;
+
+private:
+    struct Entry {
+        uint64_t value;
+        std::function<void()> destroyFunc;
+    };
+
+    VkDevice m_device;
+    mutable std::mutex m_mutex;
+    std::deque<Entry> m_entries; // Sorted by value, timeline values never decrease
+    std::vector<std::function<void()>> m_unstamped; // Released since the last stamp()
+    uint64_t m_completedValue = 0;
+};
@@ -0,0 +1,165 @@
+#include "DeviceSelector.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
+namespace {
+
+const char* deviceTypeName(VkPhysicalDeviceType type) {
+    switch (type) {
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: return "discrete";
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return "integrated";
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: return "virtual";
+        case VK_PHYSICAL_DEVICE_TYPE_CPU: return "cpu";
+        default: return "other";
+    }
+}
+
+long deviceTypeScore(VkPhysicalDeviceType type) {
+    switch (type) {
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: return 1000;
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return 500;
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: return 250;
+        case VK_PHYSICAL_DEVICE_TYPE_CPU: return 50;
+        default: return 0;
+    }
+}
+
+std::string toLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::tolower(c); });
+    return text;
+}
+
+bool isIndex(const std::string& text) {
+    return !text.empty() && std::all_of(text.begin(), text.end(), [](unsigned char c) { return std::isdigit(c); });
+}
+
+class ScoreBuilder {
+public:
+    void add(bool condition, long points, const std::string& what) {
+        if (!condition)
+            return;
+        m_terms << (m_terms.tellp() > 0 ? ", " : "") << what << " +" << points;
+        m_score += points;
+    }
+
+    DeviceScore result() const { return {true, m_score, m_terms.str()}; }
+
+private:
+    long m_score = 0;
+    std::ostringstream m_terms;
+};
+
+} // namespace
+
+DeviceCandidate makeDeviceCandidate(const PhysicalDeviceCapabilities& capabilities,
+                                    const QueueFamilyIndices& queueFamilies,
+                                    bool swapchainSupported,
+                                    const std::vector<const char*>& requiredExtensions)
+{
+    DeviceCandidate candidate;
+    candidate.name = capabilities.properties().deviceName;
+    candidate.type = capabilities.properties().deviceType;
+    candidate.deviceLocalHeapSize = capabilities.deviceLocalHeapSize();
+    candidate.queueFamilies = queueFamilies;
+    candidate.swapchainSupported = swapchainSupported;
+    for (const char* name : capabilities.missingExtensions(requiredExtensions))
+        candidate.missingExtensions.emplace_back(name);
+    candidate.limits = capabilities.limits();
+    candidate.features = capabilities.features();
+    return candidate;
+}
+
+DeviceScore scoreDevice(const DeviceCandidate& candidate) {
+    if (!candidate.missingExtensions.empty()) {
+        std::string reason = "missing";
+        for (const auto& name : candidate.missingExtensions)
+            reason += " " + name;
+        return {false, 0, reason};
+    }
+    if (candidate.queueFamilies.graphicsFamily == std::numeric_limits<unsigned>::max())
+        return {false, 0, "no graphics queue"};
+    if (candidate.queueFamilies.presentFamily == std::numeric_limits<unsigned>::max())
+        return {false, 0, "no queue can present to the surface"};
+    if (!candidate.swapchainSupported)
+        return {false, 0, "surface has no formats or present modes"};
+
+    ScoreBuilder builder;
+    builder.add(true, deviceTypeScore(candidate.type), deviceTypeName(candidate.type));
+    // 256 MiB per point, capped so memory never outweighs the device type
+    const long vramPoints = static_cast<long>(std::min<VkDeviceSize>(candidate.deviceLocalHeapSize >> 28, 128));
+    builder.add(vramPoints > 0, vramPoints, std::to_string(candidate.deviceLocalHeapSize >> 20) + " MiB VRAM");
+    builder.add(candidate.queueFamilies.hasDedicatedTransfer(), 40, "dedicated transfer");
+    builder.add(candidate.queueFamilies.hasDedicatedCompute(), 20, "dedicated compute");
+    builder.add(candidate.limits.maxImageDimension2D >= 16384, 10, "16k images");
+    builder.add(candidate.limits.maxPushConstantsSize >= 256, 5, "256 byte push constants");
+    builder.add(candidate.features.samplerAnisotropy, 10, "anisotropy");
+    builder.add(candidate.features.fillModeNonSolid, 5, "wireframe");
+    builder.add(candidate.features.multiDrawIndirect, 5, "multi draw indirect");
+    return builder.result();
+}
+
+DeviceSelection selectDevice(const std::vector<DeviceCandidate>& candidates, const std::string& gpuOverride) {
+    DeviceSelection selection;
+    selection.scores.reserve(candidates.size());
+    for (const auto& candidate : candidates)
+        selection.scores.push_back(scoreDevice(candidate));
+
+    std::vector<size_t> allowed;
+    if (gpuOverride.empty()) {
+        for (size_t i = 0; i < candidates.size(); ++i)
+            allowed.push_back(i);
+    } else if (isIndex(gpuOverride)) {
+        const size_t index = std::stoull(gpuOverride);
+        if (index >= candidates.size()) {
+            selection.error = "GPU override " + gpuOverride + " is out of range, there are "
+                            + std::to_string(candidates.size()) + " devices";
+            return selection;
+        }
+        allowed.push_back(index);
+    } else {
+        const auto pattern = toLower(gpuOverride);
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            if (toLower(candidates[i].name).find(pattern) != std::string::npos)
+                allowed.push_back(i);
+        }
+        if (allowed.empty()) {
+            selection.error = "GPU override \"" + gpuOverride + "\" matches no device";
+            return selection;
+        }
+    }
+    selection.overridden = !gpuOverride.empty();
+
+    for (size_t index : allowed) {
+        const auto& score = selection.scores[index];
+        if (score.suitable && (selection.selected == DeviceSelection::NONE
+                               || score.score > selection.scores[selection.selected].score))
+            selection.selected = index;
+    }
+    if (selection.selected == DeviceSelection::NONE)
+        selection.error = selection.overridden ? "GPU override \"" + gpuOverride + "\" only matches rejected devices"
+                                               : "Failed to find a suitable GPU!";
+    return selection;
+}
+
+void printDeviceSelection(std::ostream& stream,
+                          const std::vector<DeviceCandidate>& candidates,
+                          const DeviceSelection& selection)
+{
+    stream << "GPUs:" << std::endl;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        const auto& score = selection.scores[i];
+        stream << '\t' << i << ": " << candidates[i].name << " (" << deviceTypeName(candidates[i].type) << ") ";
+        if (score.suitable)
+            stream << "score " << score.score << " = " << score.reason;
+        else
+            stream << "rejected, " << score.reason;
+        stream << std::endl;
+    }
+    if (selection.selected == DeviceSelection::NONE)
+        stream << "No GPU selected: " << selection.error << std::endl;
+    else
+        stream << "Selected GPU " << selection.selected << ": " << candidates[selection.selected].name
+               << (selection.overridden ? " (override)" : " (highest score)") << std::endl;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstddef>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "VkPhysicalDeviceWrap.hpp"
+
+/// What device ranking needs to know about a physical device. Plain data, so a list of
+/// mocked candidates can be ranked without a driver.
+struct DeviceCandidate {
+    std::string name;
+    VkPhysicalDeviceType type = VK_PHYSICAL_DEVICE_TYPE_OTHER;
+    VkDeviceSize deviceLocalHeapSize = 0;
+    QueueFamilyIndices queueFamilies;
+    bool swapchainSupported = false;
+    std::vector<std::string> missingExtensions;
+    VkPhysicalDeviceLimits limits = {};
+    VkPhysicalDeviceFeatures features = {};
+};
+
+DeviceCandidate makeDeviceCandidate(const PhysicalDeviceCapabilities& capabilities,
+                                    const QueueFamilyIndices& queueFamilies,
+                                    bool swapchainSupported,
+                                    const std::vector<const char*>& requiredExtensions);
+
+struct DeviceScore {
+    bool suitable = false;
+    long score = 0;
+    std::string reason; // Why the device was rejected, or what its score is made of
+};
+
+struct DeviceSelection {
+    static constexpr size_t NONE = std::numeric_limits<size_t>::max();
+
+    std::vector<DeviceScore> scores; // In candidate order
+    size_t selected = NONE;
+    bool overridden = false;
+    std::string error; // Set when nothing was selected
+};
+
+DeviceScore scoreDevice(const DeviceCandidate& candidate);
+
+// gpuOverride is empty, a candidate index or a case insensitive part of a device name.
+// Without it the highest score wins, ties go to the earlier candidate.
+DeviceSelection selectDevice(const std::vector<DeviceCandidate>& candidates, const std::string& gpuOverride);
+
+void printDeviceSelection(std::ostream& stream,
+                          const std::vector<DeviceCandidate>& candidates,
+                          const DeviceSelection& selection);
@@ -0,0 +1,71 @@
+#include "FrameCommandAllocator.hpp"
+
+#include <stdexcept>
+
+#include "VkDeviceWrap.hpp"
+
+FrameCommandAllocator::FrameCommandAllocator(const VkDeviceWrap& device,
+                                             uint32_t queueFamily,
+                                             unsigned frameCount,
+                                             unsigned threadSlotCount)
+    : m_device(device)
+    , m_threadSlotCount(threadSlotCount)
+    , m_pools(frameCount * threadSlotCount)
+{
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = queueFamily;
+    // Buffers live for one frame and are only reset through the pool
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    
+    for (auto& framePool : m_pools) {
+        if (vkCreateCommandPool(device.device(), &poolInfo, nullptr, &framePool.pool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create command pool!");
+        }
+    }
+}
+
+FrameCommandAllocator::~FrameCommandAllocator() {
+    // Destroying a pool frees its command buffers
+    for (auto& framePool : m_pools)
+        vkDestroyCommandPool(m_device.device(), framePool.pool, nullptr);
+}
+
+void FrameCommandAllocator::reset(unsigned frameIndex) {
+    for (unsigned threadSlot = 0; threadSlot < m_threadSlotCount; ++threadSlot) {
+        auto& frame = pool(frameIndex, threadSlot);
+        // Resets every buffer of the pool at once, memory stays with the pool for the next frame
+        vkResetCommandPool(m_device.device(), frame.pool, 0);
+        frame.primary.usedCount = 0;
+        frame.secondary.usedCount = 0;
+    }
+}
+
+VkCommandBuffer FrameCommandAllocator::allocate(unsigned frameIndex, VkCommandBufferLevel level, unsigned threadSlot) {
+    auto& frame = pool(frameIndex, threadSlot);
+    auto& levelBuffers = level == VK_COMMAND_BUFFER_LEVEL_PRIMARY ? frame.primary : frame.secondary;
+    
+    if (levelBuffers.usedCount == levelBuffers.buffers.size()) {
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = frame.pool;
+        allocInfo.level = level;
+        allocInfo.commandBufferCount = 1;
+        
+        VkCommandBuffer commandBuffer;
+        if (vkAllocateCommandBuffers(m_device.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate command buffers!");
+        }
+        levelBuffers.buffers.push_back(commandBuffer);
+    }
+    return levelBuffers.buffers[levelBuffers.usedCount++];
+}
+
+size_t FrameCommandAllocator::allocatedCount(unsigned frameIndex) const {
+    size_t count = 0;
+    for (unsigned threadSlot = 0; threadSlot < m_threadSlotCount; ++threadSlot) {
+        const auto& frame = m_pools[frameIndex * m_threadSlotCount + threadSlot];
+        count += frame.primary.buffers.size() + frame.secondary.buffers.size();
+    }
+    return count;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+class VkDeviceWrap;
+
+/// One transient command pool per frame slot and recording thread. A frame is reset as a whole with vkResetCommandPool,
+/// command buffers it handed out are recycled on the next frame instead of being allocated again.
+/// Different threads may allocate concurrently as long as each uses its own threadSlot.
+class FrameCommandAllocator {
+public:
+    FrameCommandAllocator(const VkDeviceWrap& device, uint32_t queueFamily, unsigned frameCount, unsigned threadSlotCount = 1);
+
+    FrameCommandAllocator(const FrameCommandAllocator&) = delete;
+    FrameCommandAllocator& operator=(const FrameCommandAllocator&) = delete;
+
+    ~FrameCommandAllocator();
+
+    // GPU must be done with the frame, FrameRing::beginFrame() guarantees that
+    void reset(unsigned frameIndex);
+    // Returned buffer is in initial state and stays valid until the frame is reset
+    VkCommandBuffer allocate(unsigned frameIndex,
+                             VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                             unsigned threadSlot = 0);
+
+    size_t allocatedCount(unsigned frameIndex) const;
+
+private:
+    struct LevelBuffers {
+        std::vector<VkCommandBuffer> buffers;
+        size_t usedCount = 0;
+    };
+
+    struct FramePool {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        LevelBuffers primary;
+        LevelBuffers secondary;
+    };
+
+    const VkDeviceWrap& m_device;
+    unsigned m_threadSlotCount;
+    std::vector<FramePool> m_pools; // frameIndex * m_threadSlotCount + threadSlot
+
+    FramePool& pool(unsigned frameIndex, unsigned threadSlot) { return m_pools[frameIndex * m_threadSlotCount + threadSlot]; }
+};
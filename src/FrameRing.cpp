@@ -0,0 +1,90 @@
+#include "FrameRing.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "VkDeviceWrap.hpp"
+#include "QueueTimeline.hpp"
+#include "DeletionQueue.hpp"
+#include "CpuTracer.hpp"
+
+namespace {
+
+VkSemaphore createSemaphore(VkDevice device) {
+    VkSemaphore semaphore;
+    VkSemaphoreCreateInfo semaphoreInfo = {};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create semaphore!");
+    }
+    return semaphore;
+}
+
+} // namespace
+
+FrameRing::FrameRing(const VkDeviceWrap& device, QueueTimeline& timeline, unsigned framesInFlight, unsigned swapchainImageCount)
+    : m_device(device)
+    , m_timeline(timeline)
+    , m_imagesInFlight(swapchainImageCount, NO_FRAME)
+{
+    if (framesInFlight == 0)
+        throw std::runtime_error("At least one frame in flight is required!");
+    
+    m_frames.resize(framesInFlight);
+    for (auto& frame : m_frames)
+        frame.imageAvailableSemaphore = createSemaphore(device.device());
+    for (unsigned i = 0; i < swapchainImageCount; ++i)
+        m_renderFinishedSemaphores.push_back(createSemaphore(device.device()));
+}
+
+FrameRing::~FrameRing() {
+    for (auto semaphore : m_renderFinishedSemaphores)
+        vkDestroySemaphore(m_device.device(), semaphore, nullptr);
+    for (auto& frame : m_frames)
+        vkDestroySemaphore(m_device.device(), frame.imageAvailableSemaphore, nullptr);
+}
+
+FrameContext& FrameRing::beginFrame() {
+    auto& frame = m_frames[m_currentIndex];
+    TRACE_ZONE("wait frame timeline");
+    m_timeline.wait(frame.timelineValue);
+    frame.frameNumber = m_frameNumber;
+    return frame;
+}
+
+void FrameRing::acquireImage(uint32_t imageIndex) {
+    // Swapchain may hand images out of order, so the image can still be used by another slot
+    auto& imageSlot = m_imagesInFlight[imageIndex];
+    if (imageSlot != NO_FRAME && imageSlot != m_currentIndex)
+        m_timeline.wait(m_frames[imageSlot].timelineValue);
+    imageSlot = m_currentIndex;
+}
+
+void FrameRing::submit(const VkSubmitInfo& submitInfo) {
+    auto& frame = m_frames[m_currentIndex];
+    frame.timelineValue = m_timeline.submit(submitInfo);
+}
+
+void FrameRing::endFrame() {
+    m_currentIndex = (m_currentIndex + 1) % m_frames.size();
+    ++m_frameNumber;
+}
+
+void FrameRing::waitIdle() {
+    // Frames are the only work of the ring on the timeline, the latest one retires last
+    uint64_t lastValue = 0;
+    for (const auto& frame : m_frames)
+        lastValue = std::max(lastValue, frame.timelineValue);
+    m_timeline.wait(lastValue);
+}
+
+void FrameRing::resetImages(unsigned swapchainImageCount) {
+    m_imagesInFlight.assign(swapchainImageCount, NO_FRAME);
+    // Presents to the old swapchain may still wait on the old semaphores, they go with the old swapchain
+    auto& deletionQueue = m_device.deletionQueue();
+    for (auto semaphore : m_renderFinishedSemaphores)
+        deletionQueue.destroySemaphore(semaphore);
+    m_renderFinishedSemaphores.clear();
+    for (unsigned i = 0; i < swapchainImageCount; ++i)
+        m_renderFinishedSemaphores.push_back(createSemaphore(m_device.device()));
+}
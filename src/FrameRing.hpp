@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+class VkDeviceWrap;
+class QueueTimeline;
+
+struct FrameContext {
+    VkSemaphore imageAvailableSemaphore = VK_NULL_HANDLE;
+    uint64_t timelineValue = 0; // Reached when GPU retires the frame submitted from this slot, 0 before the first
+    uint64_t frameNumber = 0;
+};
+
+/// Ring of N frame slots. CPU may record frame K while GPU still works on frames K-1...K-N+1,
+/// it only blocks when the slot it is about to reuse hasn't been retired yet.
+class FrameRing {
+public:
+    static constexpr unsigned DEFAULT_FRAMES_IN_FLIGHT = 2;
+
+    FrameRing(const VkDeviceWrap& device, QueueTimeline& timeline, unsigned framesInFlight, unsigned swapchainImageCount);
+
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+
+    ~FrameRing();
+
+    // Waits until the current slot is retired and returns it
+    FrameContext& beginFrame();
+    // Waits for the frame which still renders into the swapchain image and claims the image for the current slot
+    void acquireImage(uint32_t imageIndex);
+    // Submits the frame recorded in the current slot through the timeline
+    void submit(const VkSubmitInfo& submitInfo);
+    void endFrame();
+    // Blocks until every slot is retired, nothing submitted from the ring is executing afterwards
+    void waitIdle();
+    // Swapchain was recreated, image indices no longer refer to the same images
+    void resetImages(unsigned swapchainImageCount);
+    // Signaled by the frame rendering into the image and waited on by its presentation
+    VkSemaphore renderFinishedSemaphore(uint32_t imageIndex) const { return m_renderFinishedSemaphores[imageIndex]; }
+
+    unsigned framesInFlight() const { return static_cast<unsigned>(m_frames.size()); }
+    unsigned currentIndex() const { return m_currentIndex; }
+    uint64_t frameNumber() const { return m_frameNumber; }
+    FrameContext& currentFrame() { return m_frames[m_currentIndex]; }
+
+private:
+    static constexpr unsigned NO_FRAME = ~0u;
+
+    const VkDeviceWrap& m_device;
+    QueueTimeline& m_timeline;
+    std::vector<FrameContext> m_frames;
+    std::vector<unsigned> m_imagesInFlight; // Slot which rendered into the image last
+    // Per image rather than per slot: a present may still wait on the semaphore when its slot comes around
+    // again, it is only known to be done once the image is acquired again (VUID-vkQueueSubmit-pSignalSemaphores-00067)
+    std::vector<VkSemaphore> m_renderFinishedSemaphores;
+    unsigned m_currentIndex = 0;
+    uint64_t m_frameNumber = 0;
+};
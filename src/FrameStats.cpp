@@ -0,0 +1,61 @@
+#include "FrameStats.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+// Nearest rank percentile over sorted values
+double percentile(const std::vector<double>& sorted, double fraction) {
+    size_t rank = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+} // namespace
+
+FrameTimeSummary FrameStats::summary() const {
+    FrameTimeSummary summary;
+    if (m_frameTimes.empty())
+        return summary;
+    
+    auto sorted = m_frameTimes;
+    std::sort(sorted.begin(), sorted.end());
+    double totalMilliseconds = std::accumulate(sorted.begin(), sorted.end(), 0.0);
+    
+    summary.frameCount = sorted.size();
+    summary.totalSeconds = totalMilliseconds / 1000.0;
+    summary.framesPerSecond = totalMilliseconds > 0.0 ? sorted.size() / summary.totalSeconds : 0.0;
+    summary.min = sorted.front();
+    summary.mean = totalMilliseconds / sorted.size();
+    summary.p50 = percentile(sorted, 0.50);
+    summary.p95 = percentile(sorted, 0.95);
+    summary.p99 = percentile(sorted, 0.99);
+    summary.max = sorted.back();
+    return summary;
+}
+
+void printFrameTimeSummary(std::ostream& stream, const FrameTimeSummary& summary) {
+    stream << summary.frameCount << " frames in " << summary.totalSeconds << " s, "
+           << summary.framesPerSecond << " fps" << std::endl;
+    stream << "CPU frame time ms: min " << summary.min
+           << ", mean " << summary.mean
+           << ", p50 " << summary.p50
+           << ", p95 " << summary.p95
+           << ", p99 " << summary.p99
+           << ", max " << summary.max << std::endl;
+}
+
+void writeFrameTimeSummaryJson(std::ostream& stream, const FrameTimeSummary& summary) {
+    stream << "{"
+           << "\"frames\": " << summary.frameCount
+           << ", \"seconds\": " << summary.totalSeconds
+           << ", \"fps\": " << summary.framesPerSecond
+           << ", \"frameTimeMs\": {"
+           << "\"min\": " << summary.min
+           << ", \"mean\": " << summary.mean
+           << ", \"p50\": " << summary.p50
+           << ", \"p95\": " << summary.p95
+           << ", \"p99\": " << summary.p99
+           << ", \"max\": " << summary.max
+           << "}}";
+}
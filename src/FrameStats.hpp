@@ -0,0 +1,36 @@
+#pragma once
+
+#include <ostream>
+#include <vector>
+
+struct FrameTimeSummary {
+    size_t frameCount = 0;
+    double totalSeconds = 0.0;
+    double framesPerSecond = 0.0;
+    // CPU frame times in milliseconds
+    double min = 0.0;
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+/// Collects CPU frame times and reduces them to percentiles.
+class FrameStats {
+public:
+    explicit FrameStats(size_t expectedFrameCount = 0) { m_frameTimes.reserve(expectedFrameCount); }
+
+    void addFrame(double milliseconds) { m_frameTimes.push_back(milliseconds); }
+    void reset() { m_frameTimes.clear(); }
+    size_t frameCount() const { return m_frameTimes.size(); }
+
+    FrameTimeSummary summary() const;
+
+private:
+    std::vector<double> m_frameTimes;
+};
+
+void printFrameTimeSummary(std::ostream& stream, const FrameTimeSummary& summary);
+// Flat object with the summary fields, meant to be embedded into a bigger JSON document
+void writeFrameTimeSummaryJson(std::ostream& stream, const FrameTimeSummary& summary);
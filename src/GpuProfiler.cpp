@@ -0,0 +1,149 @@
+#include "GpuProfiler.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "VkDeviceWrap.hpp"
+
+GpuProfiler::GpuProfiler(const VkDeviceWrap& device, uint32_t queueFamily, unsigned frameCount, uint32_t maxScopes)
+    : m_device(device)
+    , m_maxScopes(maxScopes)
+{
+    const auto& capabilities = device.physicalDevice().capabilities();
+    const auto& queueFamilies = capabilities.queueFamilies();
+    
+    const uint32_t validBits = queueFamily < queueFamilies.size() ? queueFamilies[queueFamily].timestampValidBits : 0;
+    m_enabled = validBits > 0;
+    if (!m_enabled)
+        return;
+    
+    m_timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+    m_millisecondsPerTick = double(capabilities.limits().timestampPeriod) / 1e6;
+    
+    VkQueryPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = maxScopes * 2;
+    
+    for (unsigned i = 0; i < frameCount; ++i) {
+        auto frame = std::make_unique<FrameQueries>();
+        frame->names = std::make_unique<const char*[]>(maxScopes);
+        if (vkCreateQueryPool(device.device(), &poolInfo, nullptr, &frame->pool) != VK_SUCCESS) {
+            for (auto& created : m_frames)
+                vkDestroyQueryPool(device.device(), created->pool, nullptr);
+            throw std::runtime_error("failed to create timestamp query pool!");
+        }
+        m_frames.push_back(std::move(frame));
+    }
+    m_results.resize(size_t(maxScopes) * 4);
+}
+
+GpuProfiler::~GpuProfiler() {
+    for (auto& frame : m_frames)
+        vkDestroyQueryPool(m_device.device(), frame->pool, nullptr);
+}
+
+void GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, unsigned frameIndex) {
+    if (!m_enabled)
+        return;
+    
+    auto& frame = *m_frames[frameIndex];
+    readResults(frame);
+    
+    // Queries have to be reset before they are written again, on the GPU timeline ahead of the first scope
+    vkCmdResetQueryPool(commandBuffer, frame.pool, 0, m_maxScopes * 2);
+    frame.scopeCount = 0;
+    m_currentFrame = &frame;
+}
+
+uint32_t GpuProfiler::beginScope(VkCommandBuffer commandBuffer, const char* name) {
+    if (m_currentFrame == nullptr)
+        return INVALID_SCOPE;
+    
+    const uint32_t scope = m_currentFrame->scopeCount.fetch_add(1);
+    if (scope >= m_maxScopes)
+        return INVALID_SCOPE;
+    
+    m_currentFrame->names[scope] = name;
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_currentFrame->pool, scope * 2);
+    return scope;
+}
+
+void GpuProfiler::endScope(VkCommandBuffer commandBuffer, uint32_t scope) {
+    if (scope == INVALID_SCOPE)
+        return;
+    
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_currentFrame->pool, scope * 2 + 1);
+}
+
+void GpuProfiler::readResults(FrameQueries& frame) {
+    const uint32_t scopeCount = std::min(frame.scopeCount.load(), m_maxScopes);
+    // Scopes are consumed once, a slot skipped by an out of date swapchain doesn't report them again
+    frame.scopeCount = 0;
+    if (scopeCount == 0)
+        return;
+    
+    // Slot fence is signaled so results are normally there, availability still guards queries that were never written
+    const VkResult result = vkGetQueryPoolResults(m_device.device(), frame.pool, 0, scopeCount * 2,
+                                                  scopeCount * 4 * sizeof(uint64_t), m_results.data(),
+                                                  2 * sizeof(uint64_t),
+                                                  VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    if (result != VK_SUCCESS && result != VK_NOT_READY)
+        return;
+    
+    for (auto& history : m_histories)
+        history.seenThisFrame = false;
+    
+    for (uint32_t scope = 0; scope < scopeCount; ++scope) {
+        const uint64_t* begin = &m_results[scope * 4];
+        const uint64_t* end = begin + 2;
+        if (begin[1] == 0 || end[1] == 0)
+            continue;
+        
+        const uint64_t ticks = (end[0] - begin[0]) & m_timestampMask;
+        auto& history = m_histories[findTiming(frame.names[scope])];
+        if (!history.seenThisFrame) {
+            history.seenThisFrame = true;
+            history.frameMilliseconds = 0.0;
+        }
+        history.frameMilliseconds += ticks * m_millisecondsPerTick;
+    }
+    
+    for (size_t i = 0; i < m_histories.size(); ++i) {
+        auto& history = m_histories[i];
+        if (!history.seenThisFrame)
+            continue;
+        
+        auto& timing = m_timings[i];
+        auto& sample = history.samples[timing.sampleCount % AVERAGE_WINDOW];
+        history.sum += history.frameMilliseconds - sample;
+        sample = history.frameMilliseconds;
+        ++timing.sampleCount;
+        
+        timing.lastMilliseconds = history.frameMilliseconds;
+        timing.averageMilliseconds = history.sum / double(std::min(timing.sampleCount, AVERAGE_WINDOW));
+    }
+}
+
+size_t GpuProfiler::findTiming(const char* name) {
+    for (size_t i = 0; i < m_timings.size(); ++i) {
+        if (m_timings[i].name == name)
+            return i;
+    }
+    GpuScopeTiming timing;
+    timing.name = name;
+    m_timings.push_back(std::move(timing));
+    m_histories.emplace_back();
+    return m_timings.size() - 1;
+}
+
+void printGpuTimings(std::ostream& stream, const GpuProfiler& profiler) {
+    if (!profiler.isEnabled()) {
+        stream << "GPU timings: timestamps are not supported on this queue" << std::endl;
+        return;
+    }
+    for (const auto& timing : profiler.timings()) {
+        stream << "GPU " << timing.name << ": " << timing.averageMilliseconds << " ms avg, "
+               << timing.lastMilliseconds << " ms last" << std::endl;
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class VkDeviceWrap;
+
+struct GpuScopeTiming {
+    std::string name;
+    double lastMilliseconds = 0.0;    // Sum of every scope with this name in the latest read back frame
+    double averageMilliseconds = 0.0; // Over the last AVERAGE_WINDOW frames the scope appeared in
+    size_t sampleCount = 0;
+};
+
+/// Measures GPU time of named scopes with timestamp queries. Every frame slot owns a query pool,
+/// its results are read back when the slot is reused, so the CPU never waits for them.
+/// On queue families without timestamp support (timestampValidBits == 0) every call is a no-op.
+class GpuProfiler {
+public:
+    static constexpr uint32_t DEFAULT_MAX_SCOPES = 64;
+    static constexpr size_t AVERAGE_WINDOW = 64;
+    static constexpr uint32_t INVALID_SCOPE = ~0u;
+
+    GpuProfiler(const VkDeviceWrap& device, uint32_t queueFamily, unsigned frameCount, uint32_t maxScopes = DEFAULT_MAX_SCOPES);
+
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    ~GpuProfiler();
+
+    // Called first thing in the frame's command buffer, outside of a render pass.
+    // GPU must be done with the frame, FrameRing::beginFrame() guarantees that.
+    void beginFrame(VkCommandBuffer commandBuffer, unsigned frameIndex);
+
+    // name has to outlive the profiler, string literals are expected. Thread safe between beginFrame calls.
+    uint32_t beginScope(VkCommandBuffer commandBuffer, const char* name);
+    void endScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+    bool isEnabled() const { return m_enabled; }
+    // Scopes in order of their first appearance
+    const std::vector<GpuScopeTiming>& timings() const { return m_timings; }
+
+private:
+    struct FrameQueries {
+        VkQueryPool pool = VK_NULL_HANDLE;
+        std::unique_ptr<const char*[]> names;
+        std::atomic<uint32_t> scopeCount {0};
+    };
+
+    struct ScopeHistory {
+        std::array<double, AVERAGE_WINDOW> samples {};
+        double sum = 0.0;
+        double frameMilliseconds = 0.0;
+        bool seenThisFrame = false;
+    };
+
+    const VkDeviceWrap& m_device;
+    bool m_enabled = false;
+    uint32_t m_maxScopes;
+    uint64_t m_timestampMask = 0;
+    double m_millisecondsPerTick = 0.0;
+    std::vector<std::unique_ptr<FrameQueries>> m_frames;
+    FrameQueries* m_currentFrame = nullptr;
+    std::vector<uint64_t> m_results; // Timestamp and availability pairs
+    std::vector<GpuScopeTiming> m_timings;
+    std::vector<ScopeHistory> m_histories; // Parallel to m_timings
+
+    void readResults(FrameQueries& frame);
+    size_t findTiming(const char* name);
+};
+
+/// Brackets commands with a pair of timestamps, a null profiler disables the scope.
+class GpuScope {
+public:
+    GpuScope(GpuProfiler* profiler, VkCommandBuffer commandBuffer, const char* name)
+        : m_profiler(profiler)
+        , m_commandBuffer(commandBuffer)
+        , m_scope(profiler != nullptr ? profiler->beginScope(commandBuffer, name) : GpuProfiler::INVALID_SCOPE)
+    {
+    }
+
+    GpuScope(const GpuScope&) = delete;
+    GpuScope& operator=(const GpuScope&) = delete;
+
+    ~GpuScope() {
+        if (m_profiler != nullptr)
+            m_profiler->endScope(m_commandBuffer, m_scope);
+    }
+
+private:
+    GpuProfiler* m_profiler;
+    VkCommandBuffer m_commandBuffer;
+    uint32_t m_scope;
+};
+
+void printGpuTimings(std::ostream& stream, const GpuProfiler& profiler);
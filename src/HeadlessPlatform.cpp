@@ -0,0 +1,73 @@
+#include "HeadlessPlatform.hpp"
+
+#include <chrono>
+#include <csignal>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+volatile std::sig_atomic_t g_interrupted = 0;
+
+void onInterrupt(int) {
+    g_interrupted = 1;
+}
+
+} // namespace
+
+HeadlessPlatform::HeadlessPlatform(const PlatformSettings& settings, Handler updateHandler, Handler resizeHandler)
+    : m_updateHandler(updateHandler)
+    , m_resizeHandler(resizeHandler)
+    , m_extent(settings.extent)
+    , m_targetFps(settings.targetFps)
+    , m_frameLimit(settings.frameLimit)
+{
+}
+
+std::vector<const char*> HeadlessPlatform::requiredInstanceExtensions() const {
+    return { VK_KHR_SURFACE_EXTENSION_NAME, VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME };
+}
+
+VkSurfaceKHR HeadlessPlatform::createSurface(VkInstance instance) const {
+    VkHeadlessSurfaceCreateInfoEXT createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT;
+    
+    // Not every loader exports the entry point statically
+    auto func = (PFN_vkCreateHeadlessSurfaceEXT) vkGetInstanceProcAddr(instance, "vkCreateHeadlessSurfaceEXT");
+    if (func == nullptr)
+        throw std::runtime_error("Can't find vkCreateHeadlessSurfaceEXT function");
+    
+    VkSurfaceKHR surface;
+    if (func(instance, &createInfo, nullptr, &surface) != VK_SUCCESS)
+        throw std::runtime_error("Can't create headless surface");
+    return surface;
+}
+
+void HeadlessPlatform::run() {
+    g_interrupted = 0;
+    auto previousHandler = std::signal(SIGINT, onInterrupt);
+    
+    using Clock = std::chrono::steady_clock;
+    const auto frameDuration = m_targetFps > 0
+        ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_targetFps))
+        : Clock::duration::zero();
+    auto nextFrameTime = Clock::now();
+    
+    for (uint64_t frame = 0; (m_frameLimit == 0 || frame < m_frameLimit) && !g_interrupted; ++frame) {
+        if (m_userDataPtr != nullptr)
+            m_updateHandler(m_userDataPtr);
+        if (m_targetFps > 0) {
+            // Schedule is kept absolute, so a slow frame doesn't shift the following ones
+            nextFrameTime += frameDuration;
+            std::this_thread::sleep_until(nextFrameTime);
+        }
+    }
+    
+    std::signal(SIGINT, previousHandler);
+}
+
+void HeadlessPlatform::setWindowSize(const VkExtent2D& extent) {
+    m_extent = extent;
+    if (m_resizeHandler != nullptr && m_userDataPtr != nullptr)
+        m_resizeHandler(m_userDataPtr);
+}
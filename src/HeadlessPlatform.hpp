@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Platform.hpp"
+
+/// No window, presents through VK_EXT_headless_surface. The frame loop runs on the calling thread
+/// at a fixed or unthrottled rate, so throughput can be measured on machines without a display.
+class HeadlessPlatform : public Platform {
+public:
+    HeadlessPlatform(const PlatformSettings& settings, Handler updateHandler, Handler resizeHandler);
+
+    const char* name() const override { return "headless"; }
+    std::vector<const char*> requiredInstanceExtensions() const override;
+    VkSurfaceKHR createSurface(VkInstance instance) const override;
+    void setUserData(void* userDataPtr) override { m_userDataPtr = userDataPtr; }
+    // Stops on SIGINT as well
+    void run() override;
+    void setWindowSize(const VkExtent2D& extent) override;
+    VkExtent2D windowExtent() const override { return m_extent; }
+
+private:
+    Handler m_updateHandler;
+    Handler m_resizeHandler;
+    void* m_userDataPtr = nullptr;
+    VkExtent2D m_extent;
+    unsigned m_targetFps;
+    uint64_t m_frameLimit;
+};
@@ -2,18 +2,23 @@
 
 #include <vulkan/vulkan.h>
 
+#include <cstring>
+#include <stdexcept>
+
 #include "VkBufferWrap.hpp"
 #include "VkDeviceWrap.hpp"
 
 HostBufferController::HostBufferController(const std::shared_ptr<VkBufferWrap>& bufferWrap)
     : m_bufferWrap(bufferWrap)
 {
-    if (vkMapMemory(bufferWrap->deviceWrap().device(), bufferWrap->deviceMemory(), 0, bufferWrap->size(), 0, &m_mappedMemory) != VK_SUCCESS)
+    // Host visible memory blocks are persistently mapped by VkMemoryAllocator,
+    // mapping the shared VkDeviceMemory a second time is not allowed.
+    m_mappedMemory = bufferWrap->mappedData();
+    if (m_mappedMemory == nullptr)
         throw std::runtime_error("Unable to map memory!");
 }
 
 HostBufferController::~HostBufferController() {
-    vkUnmapMemory(m_bufferWrap->deviceWrap().device(), m_bufferWrap->deviceMemory());
 }
 
 void HostBufferController::copyToMemory(const void* source, size_t size) {
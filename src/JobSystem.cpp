@@ -0,0 +1,97 @@
+#include "JobSystem.hpp"
+
+#include "CpuTracer.hpp"
+
+namespace {
+
+thread_local const JobSystem* t_jobSystem = nullptr;
+thread_local unsigned t_workerIndex = 0;
+
+} // namespace
+
+JobSystem::JobSystem(unsigned threadCount) {
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    
+    // Queues have to exist before any worker starts stealing
+    for (unsigned i = 0; i < threadCount; ++i)
+        m_queues.push_back(std::make_unique<WorkerQueue>());
+    
+    m_workers.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i)
+        m_workers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+    for (auto& worker : m_workers)
+        worker.join();
+}
+
+unsigned JobSystem::currentSlot() const {
+    return t_jobSystem == this ? t_workerIndex : threadCount();
+}
+
+void JobSystem::schedule(std::function<void()> job) {
+    // Workers keep spawned jobs local, outside threads spread them round robin
+    unsigned queueIndex = t_jobSystem == this ? t_workerIndex : m_nextQueue++ % m_queues.size();
+    // Counted before it is visible, so the counter never drops below the real number of queued jobs
+    ++m_pendingCount;
+    {
+        std::lock_guard<std::mutex> lock(m_queues[queueIndex]->mutex);
+        m_queues[queueIndex]->jobs.push_back(std::move(job));
+    }
+    {
+        // Sleeping workers check the counter under this mutex, taking it prevents a lost wakeup
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_condition.notify_one();
+}
+
+bool JobSystem::tryRunJob() {
+    const unsigned queueCount = static_cast<unsigned>(m_queues.size());
+    const unsigned self = currentSlot();
+    std::function<void()> job;
+    
+    if (self < queueCount) {
+        auto& queue = *m_queues[self];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.jobs.empty()) {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+        }
+    }
+    
+    for (unsigned i = 1; !job && i <= queueCount; ++i) {
+        auto& victim = *m_queues[(self + i) % queueCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+        }
+    }
+    
+    if (!job)
+        return false;
+    --m_pendingCount;
+    job();
+    return true;
+}
+
+void JobSystem::workerLoop(unsigned workerIndex) {
+    t_jobSystem = this;
+    t_workerIndex = workerIndex;
+    TRACE_THREAD_NAME("job worker");
+    while (true) {
+        if (tryRunJob())
+            continue;
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_condition.wait(lock, [this]() { return m_stopping || m_pendingCount != 0; });
+        if (m_stopping && m_pendingCount == 0)
+            return;
+    }
+}
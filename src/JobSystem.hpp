@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/// Fixed set of worker threads with a job deque each. Workers pop their own jobs LIFO and steal
+/// the oldest jobs of other workers when they run dry, so load balances without a shared queue.
+class JobSystem {
+public:
+    // 0 means one worker per hardware thread
+    explicit JobSystem(unsigned threadCount = 0);
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Finishes queued jobs before joining workers
+    ~JobSystem();
+
+    template <typename Func>
+    auto submit(Func&& func) -> std::future<std::invoke_result_t<std::decay_t<Func>>> {
+        using Result = std::invoke_result_t<std::decay_t<Func>>;
+        // std::function needs copyable callables, packaged_task is move only
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+        auto future = task->get_future();
+        schedule([task]() { (*task)(); });
+        return future;
+    }
+
+    // Runs func(begin, end, slot) over [0, count) split into chunks of grainSize on workers and the calling thread.
+    // slot is the worker index, or threadCount() for a thread outside of the system, so per-thread data
+    // needs threadCount() + 1 entries. Only one outside thread may run parallelFor at a time.
+    // The first exception thrown by func is rethrown on the calling thread once every chunk is done,
+    // chunks not started by then are skipped.
+    template <typename Func>
+    void parallelFor(size_t count, size_t grainSize, Func&& func) {
+        if (count == 0)
+            return;
+        grainSize = std::max<size_t>(grainSize, 1);
+        const size_t chunkCount = (count + grainSize - 1) / grainSize;
+        
+        // Helpers busy workers start late only find the loop finished, so they share the state instead of
+        // referencing this stack frame. func is only called for claimed chunks, which finish before returning.
+        auto state = std::make_shared<ParallelForState>();
+        auto runChunks = [state, count, grainSize, chunkCount, &func](unsigned slot) {
+            for (size_t chunk = state->nextChunk++; chunk < chunkCount; chunk = state->nextChunk++) {
+                if (!state->failed.load(std::memory_order_relaxed)) {
+                    try {
+                        size_t begin = chunk * grainSize;
+                        func(begin, std::min(begin + grainSize, count), slot);
+                    } catch (...) {
+                        if (!state->failed.exchange(true))
+                            state->exception = std::current_exception();
+                    }
+                }
+                state->finishedChunks.fetch_add(1, std::memory_order_release);
+            }
+        };
+        
+        const auto helperCount = static_cast<unsigned>(std::min<size_t>(threadCount(), chunkCount - 1));
+        for (unsigned i = 0; i < helperCount; ++i)
+            schedule([this, runChunks]() { runChunks(currentSlot()); });
+        
+        runChunks(currentSlot());
+        // Only chunks of this loop are waited for, running unrelated jobs (pipeline compiles) here would stall the caller
+        while (state->finishedChunks.load(std::memory_order_acquire) != chunkCount)
+            std::this_thread::yield();
+        if (state->exception)
+            std::rethrow_exception(state->exception);
+    }
+
+    unsigned threadCount() const { return static_cast<unsigned>(m_workers.size()); }
+    // Worker index on worker threads, threadCount() anywhere else
+    unsigned currentSlot() const;
+
+private:
+    struct ParallelForState {
+        std::atomic<size_t> nextChunk {0};
+        std::atomic<size_t> finishedChunks {0};
+        std::atomic<bool> failed {false};
+        std::exception_ptr exception; // Written by the chunk which set failed, before it counts as finished
+    };
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> jobs;
+    };
+
+    std::vector<std::thread> m_workers;
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+    std::atomic<size_t> m_pendingCount {0};
+    std::atomic<unsigned> m_nextQueue {0};
+    std::mutex m_sleepMutex;
+    std::condition_variable m_condition;
+    bool m_stopping = false;
+
+    void schedule(std::function<void()> job);
+    // Own queue first, then steals from the others. Returns false when every queue is empty.
+    bool tryRunJob();
+    void workerLoop(unsigned workerIndex);
+};
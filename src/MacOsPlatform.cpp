@@ -0,0 +1,42 @@
+#include "MacOsPlatform.hpp"
+
+#include <vulkan/vulkan_macos.h>
+
+#include <stdexcept>
+
+MacOsPlatform::MacOsPlatform(const PlatformSettings& settings, Handler updateHandler, Handler resizeHandler)
+    : m_app(createMacOsApp(updateHandler, resizeHandler))
+    , m_extent(settings.extent)
+{
+    setMacOsWindowSize(&m_app, m_extent.width, m_extent.height);
+}
+
+std::vector<const char*> MacOsPlatform::requiredInstanceExtensions() const {
+    return { VK_KHR_SURFACE_EXTENSION_NAME, VK_MVK_MACOS_SURFACE_EXTENSION_NAME };
+}
+
+VkSurfaceKHR MacOsPlatform::createSurface(VkInstance instance) const {
+    VkMacOSSurfaceCreateInfoMVK createInfo;
+    createInfo.sType = VK_STRUCTURE_TYPE_MACOS_SURFACE_CREATE_INFO_MVK;
+    createInfo.pNext = NULL;
+    createInfo.flags = 0;
+    createInfo.pView = m_app.caMetalLayer;
+    
+    VkSurfaceKHR surface;
+    if (vkCreateMacOSSurfaceMVK(instance, &createInfo, nullptr, &surface) != VK_SUCCESS)
+        throw std::runtime_error("Can't create macos surface");
+    return surface;
+}
+
+void MacOsPlatform::setUserData(void* userDataPtr) {
+    ::setUserData(&m_app, userDataPtr);
+}
+
+void MacOsPlatform::run() {
+    runMacOsApp(&m_app);
+}
+
+void MacOsPlatform::setWindowSize(const VkExtent2D& extent) {
+    m_extent = extent;
+    setMacOsWindowSize(&m_app, extent.width, extent.height);
+}
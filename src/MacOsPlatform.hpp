@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Platform.hpp"
+#include "macOSInterface.hpp"
+
+/// Cocoa window with a CAMetalLayer, frames are driven by CVDisplayLink.
+class MacOsPlatform : public Platform {
+public:
+    MacOsPlatform(const PlatformSettings& settings, Handler updateHandler, Handler resizeHandler);
+
+    const char* name() const override { return "macOS"; }
+    std::vector<const char*> requiredInstanceExtensions() const override;
+    VkSurfaceKHR createSurface(VkInstance instance) const override;
+    void setUserData(void* userDataPtr) override;
+    void run() override;
+    void setWindowSize(const VkExtent2D& extent) override;
+    VkExtent2D windowExtent() const override { return m_extent; }
+
+private:
+    MacOsApp m_app;
+    VkExtent2D m_extent;
+};
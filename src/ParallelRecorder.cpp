@@ -0,0 +1,73 @@
+#include "ParallelRecorder.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "JobSystem.hpp"
+#include "CpuTracer.hpp"
+
+ParallelRecorder::ParallelRecorder(const VkDeviceWrap& device, uint32_t queueFamily, unsigned frameCount, JobSystem* jobSystem)
+    : m_jobSystem(jobSystem)
+    // Calling thread records too and takes the last slot
+    , m_commandAllocator(device, queueFamily, frameCount, jobSystem != nullptr ? jobSystem->threadCount() + 1 : 1)
+{
+}
+
+void ParallelRecorder::reset(unsigned frameIndex) {
+    m_commandAllocator.reset(frameIndex);
+}
+
+void ParallelRecorder::record(VkCommandBuffer primaryCommandBuffer,
+                              unsigned frameIndex,
+                              VkRenderPass renderPass,
+                              uint32_t subpass,
+                              VkFramebuffer framebuffer,
+                              size_t drawCount,
+                              size_t drawsPerBuffer,
+                              const RangeRecordFunc& func)
+{
+    if (drawCount == 0)
+        return;
+    drawsPerBuffer = std::max<size_t>(drawsPerBuffer, 1);
+    const size_t bufferCount = (drawCount + drawsPerBuffer - 1) / drawsPerBuffer;
+    m_secondaryBuffers.resize(bufferCount);
+    
+    VkCommandBufferInheritanceInfo inheritanceInfo = {};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass = renderPass;
+    inheritanceInfo.subpass = subpass;
+    inheritanceInfo.framebuffer = framebuffer;
+    
+    auto recordBuffers = [&](size_t firstBuffer, size_t lastBuffer, unsigned threadSlot) {
+        TRACE_ZONE("record secondary buffers");
+        for (size_t i = firstBuffer; i < lastBuffer; ++i) {
+            VkCommandBuffer commandBuffer = m_commandAllocator.allocate(frameIndex, VK_COMMAND_BUFFER_LEVEL_SECONDARY, threadSlot);
+            
+            VkCommandBufferBeginInfo beginInfo = {};
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+            beginInfo.pInheritanceInfo = &inheritanceInfo;
+            if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+                throw std::runtime_error("failed to begin recording command buffer!");
+            }
+            size_t begin = i * drawsPerBuffer;
+            func(commandBuffer, begin, std::min(begin + drawsPerBuffer, drawCount));
+            if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("failed to record command buffer!");
+            }
+            // Slots are indexed by position, so execution order doesn't depend on scheduling
+            m_secondaryBuffers[i] = commandBuffer;
+        }
+    };
+    
+    if (m_jobSystem != nullptr)
+        m_jobSystem->parallelFor(bufferCount, 1, recordBuffers);
+    else
+        recordBuffers(0, bufferCount, 0);
+    
+    vkCmdExecuteCommands(primaryCommandBuffer, static_cast<uint32_t>(bufferCount), m_secondaryBuffers.data());
+}
+
+unsigned ParallelRecorder::threadCount() const {
+    return m_jobSystem != nullptr ? m_jobSystem->threadCount() + 1 : 1;
+}
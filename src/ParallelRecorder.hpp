@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <functional>
+#include <vector>
+
+#include "FrameCommandAllocator.hpp"
+
+class VkDeviceWrap;
+class JobSystem;
+
+/// Splits a draw list across JobSystem workers. Every worker records secondary command buffers
+/// from its own pool, the primary buffer then executes them in draw order.
+class ParallelRecorder {
+public:
+    // Records draws [begin, end) into a secondary buffer which is already begun
+    using RangeRecordFunc = std::function<void(VkCommandBuffer commandBuffer, size_t begin, size_t end)>;
+
+    // Without a job system everything is recorded on the calling thread
+    ParallelRecorder(const VkDeviceWrap& device, uint32_t queueFamily, unsigned frameCount, JobSystem* jobSystem);
+
+    ParallelRecorder(const ParallelRecorder&) = delete;
+    ParallelRecorder& operator=(const ParallelRecorder&) = delete;
+
+    // Called once per frame before record(), GPU must be done with the frame
+    void reset(unsigned frameIndex);
+
+    // Must be called inside a render pass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+    // Secondary buffers don't inherit dynamic state, func has to set viewport and scissor itself.
+    void record(VkCommandBuffer primaryCommandBuffer,
+                unsigned frameIndex,
+                VkRenderPass renderPass,
+                uint32_t subpass,
+                VkFramebuffer framebuffer,
+                size_t drawCount,
+                size_t drawsPerBuffer,
+                const RangeRecordFunc& func);
+
+    unsigned threadCount() const;
+
+private:
+    JobSystem* m_jobSystem;
+    FrameCommandAllocator m_commandAllocator;
+    std::vector<VkCommandBuffer> m_secondaryBuffers; // Reused between frames
+};
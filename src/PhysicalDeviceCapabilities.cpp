@@ -0,0 +1,89 @@
+#include "PhysicalDeviceCapabilities.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+uint32_t lowestBitIndex(uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<uint32_t>(__builtin_ctz(mask));
+#else
+    uint32_t index = 0;
+    while ((mask & 1u) == 0) {
+        mask >>= 1;
+        ++index;
+    }
+    return index;
+#endif
+}
+
+}
+
+PhysicalDeviceCapabilities::PhysicalDeviceCapabilities(VkPhysicalDevice physicalDevice)
+    : m_physicalDevice(physicalDevice)
+{
+    vkGetPhysicalDeviceProperties(physicalDevice, &m_properties);
+    vkGetPhysicalDeviceFeatures(physicalDevice, &m_features);
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_memoryProperties);
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+    m_queueFamilies.resize(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, m_queueFamilies.data());
+
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+    m_extensions.reserve(extensionCount);
+    for (const auto& extension : extensions)
+        m_extensions.emplace_back(extension.extensionName);
+    std::sort(m_extensions.begin(), m_extensions.end());
+
+    for (uint32_t i = 0; i < m_memoryProperties.memoryHeapCount; ++i) {
+        const auto& heap = m_memoryProperties.memoryHeaps[i];
+        if (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+            m_deviceLocalHeapSize = std::max(m_deviceLocalHeapSize, heap.size);
+    }
+
+    for (VkMemoryPropertyFlags flags = 0; flags <= TABLE_FLAGS; ++flags) {
+        uint32_t mask = 0;
+        for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; ++i) {
+            if ((m_memoryProperties.memoryTypes[i].propertyFlags & flags) == flags)
+                mask |= 1u << i;
+        }
+        m_memoryTypesByFlags[flags] = mask;
+    }
+}
+
+bool PhysicalDeviceCapabilities::hasExtension(const char* name) const {
+    auto it = std::lower_bound(m_extensions.begin(), m_extensions.end(), name,
+                               [](const std::string& extension, const char* value) {
+                                   return std::strcmp(extension.c_str(), value) < 0;
+                               });
+    return it != m_extensions.end() && *it == name;
+}
+
+std::vector<const char*> PhysicalDeviceCapabilities::missingExtensions(const std::vector<const char*>& required) const {
+    std::vector<const char*> missing;
+    for (const char* name : required) {
+        if (!hasExtension(name))
+            missing.push_back(name);
+    }
+    return missing;
+}
+
+uint32_t PhysicalDeviceCapabilities::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+    uint32_t candidates = 0;
+    if ((properties & ~TABLE_FLAGS) == 0) {
+        candidates = m_memoryTypesByFlags[properties] & typeFilter;
+    } else {
+        // Rare bits like PROTECTED aren't in the table
+        for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; ++i) {
+            if ((typeFilter & (1u << i)) && (m_memoryProperties.memoryTypes[i].propertyFlags & properties) == properties)
+                candidates |= 1u << i;
+        }
+    }
+    return candidates != 0 ? lowestBitIndex(candidates) : NO_MEMORY_TYPE;
+}
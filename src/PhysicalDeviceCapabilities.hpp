@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <string>
+#include <vector>
+
+/// Everything the renderer asks the driver about a physical device, captured once.
+/// Device selection, the allocator and the profilers read from here instead of calling
+/// vkGetPhysicalDevice* again. The snapshot never changes after construction.
+class PhysicalDeviceCapabilities {
+public:
+    static constexpr uint32_t NO_MEMORY_TYPE = ~0u;
+
+    explicit PhysicalDeviceCapabilities(VkPhysicalDevice physicalDevice);
+
+    VkPhysicalDevice physicalDevice() const { return m_physicalDevice; }
+    const VkPhysicalDeviceProperties& properties() const { return m_properties; }
+    const VkPhysicalDeviceLimits& limits() const { return m_properties.limits; }
+    const VkPhysicalDeviceFeatures& features() const { return m_features; }
+    const VkPhysicalDeviceMemoryProperties& memoryProperties() const { return m_memoryProperties; }
+    const std::vector<VkQueueFamilyProperties>& queueFamilies() const { return m_queueFamilies; }
+    // Sorted by name
+    const std::vector<std::string>& extensions() const { return m_extensions; }
+
+    bool hasExtension(const char* name) const;
+    std::vector<const char*> missingExtensions(const std::vector<const char*>& required) const;
+
+    VkMemoryPropertyFlags memoryTypeFlags(uint32_t memoryTypeIndex) const {
+        return m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+    }
+    // Size of the biggest device local heap
+    VkDeviceSize deviceLocalHeapSize() const { return m_deviceLocalHeapSize; }
+
+    // First memory type allowed by typeFilter that has all the properties, NO_MEMORY_TYPE if none does.
+    // Property combinations made of the common bits are answered from a precomputed table.
+    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+
+private:
+    // DEVICE_LOCAL, HOST_VISIBLE, HOST_COHERENT, HOST_CACHED and LAZILY_ALLOCATED, every usage class is a mix of these
+    static constexpr VkMemoryPropertyFlags TABLE_FLAGS = 0x1f;
+
+    VkPhysicalDevice m_physicalDevice;
+    VkPhysicalDeviceProperties m_properties;
+    VkPhysicalDeviceFeatures m_features;
+    VkPhysicalDeviceMemoryProperties m_memoryProperties;
+    std::vector<VkQueueFamilyProperties> m_queueFamilies;
+    std::vector<std::string> m_extensions;
+    VkDeviceSize m_deviceLocalHeapSize = 0;
+    // Bit i is set when memory type i has every flag of the index
+    std::array<uint32_t, TABLE_FLAGS + 1> m_memoryTypesByFlags = {};
+};
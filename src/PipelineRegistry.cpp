@@ -0,0 +1,217 @@
+#include "PipelineRegistry.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+
+#include "JobSystem.hpp"
+#include "CpuTracer.hpp"
+
+namespace {
+
+template <typename T>
+void hashCombine(size_t& seed, const T& value) {
+    size_t valueHash;
+    if constexpr (std::is_pointer_v<T>)
+        valueHash = std::hash<const void*>()(value);
+    else if constexpr (std::is_enum_v<T>)
+        valueHash = std::hash<std::underlying_type_t<T>>()(value);
+    else
+        valueHash = std::hash<T>()(value);
+    seed ^= valueHash + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+VkPipelineShaderStageCreateInfo prepareStageCreateInfo(VkShaderStageFlagBits stage, VkShaderModule module) {
+    VkPipelineShaderStageCreateInfo vertShaderStageInfo = {};
+    vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    vertShaderStageInfo.stage = stage;
+    vertShaderStageInfo.module = module;
+    vertShaderStageInfo.pName = "main";
+    return vertShaderStageInfo;
+}
+
+VkPipeline createGraphicsPipeline(VkDevice device, VkPipelineCache pipelineCache, const PipelineDesc& desc) {
+    VkPipelineShaderStageCreateInfo shaderStagesCreateInfo[] = {
+        prepareStageCreateInfo(VK_SHADER_STAGE_VERTEX_BIT, desc.vertexShader),
+        prepareStageCreateInfo(VK_SHADER_STAGE_FRAGMENT_BIT, desc.fragmentShader)
+    };
+
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(desc.vertexBindings.size());
+    vertexInputInfo.pVertexBindingDescriptions = desc.vertexBindings.data();
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(desc.vertexAttributes.size());
+    vertexInputInfo.pVertexAttributeDescriptions = desc.vertexAttributes.data();
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = desc.topology;
+    inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+    // Viewport and scissor are dynamic, so pipelines survive swapchain resizes
+    VkPipelineViewportStateCreateInfo viewportState = {};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.pViewports = nullptr;
+    viewportState.scissorCount = 1;
+    viewportState.pScissors = nullptr;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer = {};
+    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.depthClampEnable = VK_FALSE;
+    rasterizer.rasterizerDiscardEnable = VK_FALSE;
+    rasterizer.polygonMode = desc.polygonMode;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = desc.cullMode;
+    rasterizer.frontFace = desc.frontFace;
+    rasterizer.depthBiasEnable = VK_FALSE;
+    rasterizer.depthBiasConstantFactor = 0.0f; // Optional
+    rasterizer.depthBiasClamp = 0.0f; // Optional
+    rasterizer.depthBiasSlopeFactor = 0.0f; // Optional
+
+    VkPipelineMultisampleStateCreateInfo multisampling = {};
+    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.sampleShadingEnable = VK_FALSE;
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    multisampling.minSampleShading = 1.0f; // Optional
+    multisampling.pSampleMask = nullptr; // Optional
+    multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
+    multisampling.alphaToOneEnable = VK_FALSE; // Optional
+
+    VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
+    colorBlendAttachment.colorWriteMask = desc.colorWriteMask;
+    colorBlendAttachment.blendEnable = desc.blendEnable;
+    colorBlendAttachment.srcColorBlendFactor = desc.srcColorBlendFactor;
+    colorBlendAttachment.dstColorBlendFactor = desc.dstColorBlendFactor;
+    colorBlendAttachment.colorBlendOp = desc.colorBlendOp;
+    colorBlendAttachment.srcAlphaBlendFactor = desc.srcAlphaBlendFactor;
+    colorBlendAttachment.dstAlphaBlendFactor = desc.dstAlphaBlendFactor;
+    colorBlendAttachment.alphaBlendOp = desc.alphaBlendOp;
+
+    VkPipelineColorBlendStateCreateInfo colorBlending = {};
+    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    // Logic ops need a device feature that is never enabled and would replace blending
+    colorBlending.logicOpEnable = VK_FALSE;
+    colorBlending.logicOp = VK_LOGIC_OP_COPY; // Optional
+    colorBlending.attachmentCount = 1;
+    colorBlending.pAttachments = &colorBlendAttachment;
+    colorBlending.blendConstants[0] = 0.0f; // Optional
+    colorBlending.blendConstants[1] = 0.0f; // Optional
+    colorBlending.blendConstants[2] = 0.0f; // Optional
+    colorBlending.blendConstants[3] = 0.0f; // Optional
+
+    VkDynamicState dynamicStates[] = {
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR
+    };
+
+    VkPipelineDynamicStateCreateInfo dynamicState = {};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = 2;
+    dynamicState.pDynamicStates = dynamicStates;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = 2;
+    pipelineInfo.pStages = shaderStagesCreateInfo;
+    pipelineInfo.pVertexInputState = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState = &multisampling;
+    pipelineInfo.pDepthStencilState = nullptr; // Optional
+    pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.layout = desc.layout;
+    pipelineInfo.renderPass = desc.renderPass;
+    pipelineInfo.subpass = desc.subpass;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
+    pipelineInfo.basePipelineIndex = -1; // Optional
+
+    VkPipeline graphicsPipeline;
+
+    TRACE_ZONE("vkCreateGraphicsPipelines");
+    // Pipeline cache is internally synchronized, workers may share it
+    if (vkCreateGraphicsPipelines(device, pipelineCache, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create graphics pipeline!");
+    }
+
+    return graphicsPipeline;
+}
+
+} // namespace
+
+bool PipelineDesc::operator==(const PipelineDesc& other) const {
+    if (scalarFields() != other.scalarFields())
+        return false;
+    
+    auto sameBindings = [](const auto& a, const auto& b) {
+        return a.binding == b.binding && a.stride == b.stride && a.inputRate == b.inputRate;
+    };
+    auto sameAttributes = [](const auto& a, const auto& b) {
+        return a.location == b.location && a.binding == b.binding && a.format == b.format && a.offset == b.offset;
+    };
+    return std::equal(vertexBindings.begin(), vertexBindings.end(),
+                      other.vertexBindings.begin(), other.vertexBindings.end(), sameBindings)
+        && std::equal(vertexAttributes.begin(), vertexAttributes.end(),
+                      other.vertexAttributes.begin(), other.vertexAttributes.end(), sameAttributes);
+}
+
+size_t PipelineDesc::hash() const {
+    size_t seed = 0;
+    std::apply([&seed](const auto&... fields) { (hashCombine(seed, fields), ...); }, scalarFields());
+    for (const auto& binding : vertexBindings) {
+        hashCombine(seed, binding.binding);
+        hashCombine(seed, binding.stride);
+        hashCombine(seed, binding.inputRate);
+    }
+    for (const auto& attribute : vertexAttributes) {
+        hashCombine(seed, attribute.location);
+        hashCombine(seed, attribute.binding);
+        hashCombine(seed, attribute.format);
+        hashCombine(seed, attribute.offset);
+    }
+    return seed;
+}
+
+PipelineRegistry::PipelineRegistry(VkDevice device, VkPipelineCache pipelineCache, JobSystem& jobSystem)
+    : m_device(device)
+    , m_pipelineCache(pipelineCache)
+    , m_jobSystem(jobSystem)
+{
+}
+
+PipelineRegistry::~PipelineRegistry() {
+    for (auto& entry : m_pipelines) {
+        try {
+            vkDestroyPipeline(m_device, entry.second.get(), nullptr);
+        } catch (const std::exception&) {
+            // Compilation failed, nothing to destroy
+        }
+    }
+}
+
+std::shared_future<VkPipeline> PipelineRegistry::request(const PipelineDesc& desc) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    auto it = m_pipelines.find(desc);
+    if (it != m_pipelines.end()) {
+        ++m_hitCount;
+        return it->second;
+    }
+    
+    ++m_missCount;
+    auto device = m_device;
+    auto pipelineCache = m_pipelineCache;
+    auto future = m_jobSystem.submit([device, pipelineCache, desc]() {
+        return createGraphicsPipeline(device, pipelineCache, desc);
+    }).share();
+    m_pipelines.emplace(desc, future);
+    return future;
+}
+
+size_t PipelineRegistry::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pipelines.size();
+}
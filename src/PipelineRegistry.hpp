@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+class JobSystem;
+
+/// Complete state of a graphics pipeline, two equal descriptions always produce interchangeable pipelines.
+struct PipelineDesc {
+    VkShaderModule vertexShader = VK_NULL_HANDLE;
+    VkShaderModule fragmentShader = VK_NULL_HANDLE;
+    
+    std::vector<VkVertexInputBindingDescription> vertexBindings;
+    std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+    VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    
+    VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+    VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+    VkFrontFace frontFace = VK_FRONT_FACE_CLOCKWISE;
+    
+    VkBool32 blendEnable = VK_TRUE;
+    VkBlendFactor srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    VkBlendFactor dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    VkBlendOp colorBlendOp = VK_BLEND_OP_ADD;
+    VkBlendFactor srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    VkBlendFactor dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    VkBlendOp alphaBlendOp = VK_BLEND_OP_ADD;
+    VkColorComponentFlags colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT
+                                           | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    uint32_t subpass = 0;
+    
+    // Every scalar field, used for comparison and hashing
+    auto scalarFields() const {
+        return std::tie(vertexShader, fragmentShader, topology, polygonMode, cullMode, frontFace,
+                        blendEnable, srcColorBlendFactor, dstColorBlendFactor, colorBlendOp,
+                        srcAlphaBlendFactor, dstAlphaBlendFactor, alphaBlendOp, colorWriteMask,
+                        layout, renderPass, subpass);
+    }
+    
+    bool operator==(const PipelineDesc& other) const;
+    size_t hash() const;
+};
+
+struct PipelineDescHash {
+    size_t operator()(const PipelineDesc& desc) const { return desc.hash(); }
+};
+
+/// Owns graphics pipelines keyed by their full state. Hits return the existing pipeline,
+/// misses are compiled on JobSystem workers, so many variants build in parallel.
+class PipelineRegistry {
+public:
+    PipelineRegistry(VkDevice device, VkPipelineCache pipelineCache, JobSystem& jobSystem);
+
+    PipelineRegistry(const PipelineRegistry&) = delete;
+    PipelineRegistry& operator=(const PipelineRegistry&) = delete;
+
+    // Waits for pending compilations and destroys all pipelines
+    ~PipelineRegistry();
+
+    // Never blocks, the future is ready right away on a hit
+    std::shared_future<VkPipeline> request(const PipelineDesc& desc);
+    // Blocks until the pipeline is compiled
+    VkPipeline get(const PipelineDesc& desc) { return request(desc).get(); }
+
+    size_t size() const;
+    size_t hitCount() const { return m_hitCount; }
+    size_t missCount() const { return m_missCount; }
+
+private:
+    VkDevice m_device;
+    VkPipelineCache m_pipelineCache;
+    JobSystem& m_jobSystem;
+    mutable std::mutex m_mutex;
+    std::unordered_map<PipelineDesc, std::shared_future<VkPipeline>, PipelineDescHash> m_pipelines;
+    std::atomic<size_t> m_hitCount {0};
+    std::atomic<size_t> m_missCount {0};
+};
@@ -0,0 +1,17 @@
+#include "Platform.hpp"
+
+#include "HeadlessPlatform.hpp"
+#ifdef __APPLE__
+#include "MacOsPlatform.hpp"
+#endif
+
+std::unique_ptr<Platform> createPlatform(const PlatformSettings& settings,
+                                         Platform::Handler updateHandler,
+                                         Platform::Handler resizeHandler)
+{
+#ifdef __APPLE__
+    if (!settings.headless)
+        return std::make_unique<MacOsPlatform>(settings, updateHandler, resizeHandler);
+#endif
+    return std::make_unique<HeadlessPlatform>(settings, updateHandler, resizeHandler);
+}
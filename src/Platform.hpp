@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <vector>
+
+struct PlatformSettings {
+    bool headless = false;
+    VkExtent2D extent = {640, 640};
+    // Headless only, frames per second of the frame loop, 0 runs unthrottled
+    unsigned targetFps = 0;
+    // Headless only, the loop stops after this many frames, 0 runs until interrupted
+    uint64_t frameLimit = 0;
+};
+
+/// Window system layer: surface creation and the frame loop calling the update handler.
+class Platform {
+public:
+    using Handler = void (*)(void* userDataPtr);
+
+    virtual ~Platform() = default;
+
+    virtual const char* name() const = 0;
+    virtual std::vector<const char*> requiredInstanceExtensions() const = 0;
+    // Ownership goes to the caller
+    virtual VkSurfaceKHR createSurface(VkInstance instance) const = 0;
+    // Handlers are called only while user data is set
+    virtual void setUserData(void* userDataPtr) = 0;
+    // Blocks until the window is closed or the frame limit is reached
+    virtual void run() = 0;
+    virtual void setWindowSize(const VkExtent2D& extent) = 0;
+    virtual VkExtent2D windowExtent() const = 0;
+};
+
+// macOS window unless headless is requested, other systems always get the headless backend
+std::unique_ptr<Platform> createPlatform(const PlatformSettings& settings,
+                                         Platform::Handler updateHandler,
+                                         Platform::Handler resizeHandler);
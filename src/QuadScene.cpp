@@ -0,0 +1,124 @@
+#include "QuadScene.hpp"
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "VkDeviceWrap.hpp"
+#include "PipelineRegistry.hpp"
+
+namespace {
+
+constexpr uint32_t INDICES_PER_QUAD = 6;
+
+} // namespace
+
+VkVertexInputBindingDescription Vertex::getBindingDescription() {
+    VkVertexInputBindingDescription bindingDescription = {};
+    bindingDescription.binding = 0;
+    bindingDescription.stride = sizeof(Vertex);
+    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    return bindingDescription;
+}
+
+std::array<VkVertexInputAttributeDescription, 2> Vertex::getAttributeDescriptions() {
+    std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions = {};
+    attributeDescriptions[0].binding = 0;
+    attributeDescriptions[0].location = 0;
+    attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
+    attributeDescriptions[0].offset = offsetof(Vertex, pos);
+    attributeDescriptions[1].binding = 0;
+    attributeDescriptions[1].location = 1;
+    attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
+    attributeDescriptions[1].offset = offsetof(Vertex, color);
+    return attributeDescriptions;
+}
+
+QuadScene::QuadScene(const VkDeviceWrap& device, UploadQueue& uploadQueue, size_t quadCount)
+    : m_quadCount(quadCount)
+{
+    if (quadCount == 0)
+        throw std::runtime_error("Scene needs at least one quad");
+    
+    // Square grid, every quad takes half of its cell, so one quad spans [-0.5, 0.5]
+    const auto gridSize = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(quadCount))));
+    const float cellSize = 2.0f / gridSize;
+    const float halfQuad = cellSize / 4.0f;
+    
+    std::vector<Vertex> vertices;
+    vertices.reserve(quadCount * 4);
+    std::vector<uint32_t> indices;
+    indices.reserve(quadCount * INDICES_PER_QUAD);
+    for (size_t i = 0; i < quadCount; ++i) {
+        float centerX = -1.0f + cellSize * (i % gridSize + 0.5f);
+        float centerY = -1.0f + cellSize * (i / gridSize + 0.5f);
+        auto base = static_cast<uint32_t>(vertices.size());
+        vertices.push_back({{centerX - halfQuad, centerY - halfQuad}, {1.0f, 0.0f, 0.0f}});
+        vertices.push_back({{centerX + halfQuad, centerY - halfQuad}, {0.0f, 1.0f, 0.0f}});
+        vertices.push_back({{centerX + halfQuad, centerY + halfQuad}, {0.0f, 0.0f, 1.0f}});
+        vertices.push_back({{centerX - halfQuad, centerY + halfQuad}, {1.0f, 1.0f, 1.0f}});
+        for (uint32_t index : {0u, 1u, 2u, 2u, 3u, 0u})
+            indices.push_back(base + index);
+    }
+    
+    m_vertexBuffer = std::make_shared<VkBufferWrap>(device,
+                                                    sizeof(vertices[0]) * vertices.size(),
+                                                    VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    uploadQueue.uploadBuffer(vertices.data(), m_vertexBuffer->size(), m_vertexBuffer->buffer());
+    
+    m_indexBuffer = std::make_shared<VkBufferWrap>(device,
+                                                   sizeof(indices[0]) * indices.size(),
+                                                   VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    uploadQueue.uploadBuffer(indices.data(), m_indexBuffer->size(), m_indexBuffer->buffer());
+    
+    // Both uploads go to GPU in one submission, rest of the initialization overlaps with it
+    m_uploadTicket = uploadQueue.flush();
+}
+
+void QuadScene::fillPipelineDesc(PipelineDesc& desc) const {
+    auto attributeDescriptions = Vertex::getAttributeDescriptions();
+    desc.vertexBindings = {Vertex::getBindingDescription()};
+    desc.vertexAttributes = {attributeDescriptions.begin(), attributeDescriptions.end()};
+}
+
+void QuadScene::record(VkCommandBuffer commandBuffer,
+                       VkPipeline pipeline,
+                       const VkExtent2D& extent,
+                       size_t firstDraw,
+                       size_t lastDraw,
+                       size_t drawCount) const
+{
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    
+    VkViewport viewport = {};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = (float) extent.width;
+    viewport.height = (float) extent.height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    
+    VkRect2D scissor = {};
+    scissor.offset = {0, 0};
+    scissor.extent = extent;
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    
+    VkBuffer vertexBuffers[] = {m_vertexBuffer->buffer()};
+    VkDeviceSize offsets[] = {0};
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+    
+    vkCmdBindIndexBuffer(commandBuffer, m_indexBuffer->buffer(), 0, VK_INDEX_TYPE_UINT32);
+    
+    for (size_t draw = firstDraw; draw < lastDraw; ++draw) {
+        size_t firstQuad = m_quadCount * draw / drawCount;
+        size_t lastQuad = m_quadCount * (draw + 1) / drawCount;
+        if (firstQuad == lastQuad)
+            lastQuad = firstQuad + 1;
+        vkCmdDrawIndexed(commandBuffer,
+                         static_cast<uint32_t>((lastQuad - firstQuad) * INDICES_PER_QUAD), 1,
+                         static_cast<uint32_t>(firstQuad * INDICES_PER_QUAD), 0, 0);
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <memory>
+
+#include "UploadQueue.hpp"
+
+class VkDeviceWrap;
+class VkBufferWrap;
+struct PipelineDesc;
+
+struct Vec2 {
+    float x;
+    float y;
+};
+
+struct Vec3 {
+    float x;
+    float y;
+    float z;
+};
+
+struct Vec4 {
+    float x;
+    float y;
+    float z;
+    float w;
+};
+
+struct Vertex {
+    Vec2 pos;
+    Vec3 color;
+    
+    static VkVertexInputBindingDescription getBindingDescription();
+    static std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions();
+};
+
+/// Grid of colored quads covering the viewport, a single quad is the classic demo picture.
+/// The grid can be drawn in any number of indexed draws to load the CPU side of the renderer.
+class QuadScene {
+public:
+    QuadScene(const VkDeviceWrap& device, UploadQueue& uploadQueue, size_t quadCount);
+
+    // Vertex layout of the scene
+    void fillPipelineDesc(PipelineDesc& desc) const;
+
+    // Binds pipeline, dynamic state and buffers, then records draws [firstDraw, lastDraw)
+    // of the scene split into drawCount draws. Draws repeat quads when there are more draws than quads.
+    void record(VkCommandBuffer commandBuffer,
+                VkPipeline pipeline,
+                const VkExtent2D& extent,
+                size_t firstDraw,
+                size_t lastDraw,
+                size_t drawCount) const;
+
+    size_t quadCount() const { return m_quadCount; }
+    // Buffers must not be drawn before the upload is complete
+    UploadTicket uploadTicket() const { return m_uploadTicket; }
+
+private:
+    size_t m_quadCount;
+    std::shared_ptr<VkBufferWrap> m_vertexBuffer;
+    std::shared_ptr<VkBufferWrap> m_indexBuffer;
+    UploadTicket m_uploadTicket;
+};
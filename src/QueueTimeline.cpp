@@ -0,0 +1,192 @@
+#include "QueueTimeline.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "VkDeviceWrap.hpp"
+#include "CpuTracer.hpp"
+
+QueueTimeline::QueueTimeline(const VkDeviceWrap& device, VkQueue queue)
+    : m_device(device)
+    , m_queue(queue)
+{
+#ifdef VK_KHR_timeline_semaphore
+    if (!device.timelineSemaphoresEnabled())
+        return;
+
+    m_getSemaphoreCounterValue = reinterpret_cast<PFN_vkGetSemaphoreCounterValueKHR>(
+        vkGetDeviceProcAddr(device.device(), "vkGetSemaphoreCounterValueKHR"));
+    m_waitSemaphores = reinterpret_cast<PFN_vkWaitSemaphoresKHR>(
+        vkGetDeviceProcAddr(device.device(), "vkWaitSemaphoresKHR"));
+    if (m_getSemaphoreCounterValue == nullptr || m_waitSemaphores == nullptr)
+        return;
+
+    VkSemaphoreTypeCreateInfoKHR typeInfo = {};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+    typeInfo.initialValue = 0;
+    VkSemaphoreCreateInfo semaphoreInfo = {};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &typeInfo;
+    if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &m_semaphore) != VK_SUCCESS)
+        throw std::runtime_error("failed to create timeline semaphore!");
+#endif
+}
+
+QueueTimeline::~QueueTimeline() {
+    waitIdle();
+
+    // Every pending fence was retired by the wait
+    for (auto fence : m_freeFences)
+        vkDestroyFence(m_device.device(), fence, nullptr);
+    if (m_semaphore != VK_NULL_HANDLE)
+        vkDestroySemaphore(m_device.device(), m_semaphore, nullptr);
+}
+
+uint64_t QueueTimeline::submit(const VkSubmitInfo& submitInfo) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const uint64_t value = m_submittedValue.load(std::memory_order_relaxed) + 1;
+
+#ifdef VK_KHR_timeline_semaphore
+    if (m_semaphore != VK_NULL_HANDLE) {
+        m_signalSemaphores.assign(submitInfo.pSignalSemaphores, submitInfo.pSignalSemaphores + submitInfo.signalSemaphoreCount);
+        m_signalSemaphores.push_back(m_semaphore);
+        // Values of binary semaphores are ignored, but every signal semaphore needs one
+        m_signalValues.assign(submitInfo.signalSemaphoreCount, 0);
+        m_signalValues.push_back(value);
+
+        VkTimelineSemaphoreSubmitInfoKHR timelineInfo = {};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR;
+        timelineInfo.pNext = submitInfo.pNext;
+        timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(m_signalValues.size());
+        timelineInfo.pSignalSemaphoreValues = m_signalValues.data();
+
+        VkSubmitInfo timelineSubmitInfo = submitInfo;
+        timelineSubmitInfo.pNext = &timelineInfo;
+        timelineSubmitInfo.signalSemaphoreCount = static_cast<uint32_t>(m_signalSemaphores.size());
+        timelineSubmitInfo.pSignalSemaphores = m_signalSemaphores.data();
+        if (vkQueueSubmit(m_queue, 1, &timelineSubmitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+            throw std::runtime_error("failed to submit to queue timeline!");
+        m_submittedValue.store(value, std::memory_order_release);
+        return value;
+    }
+#endif
+
+    VkFence fence = acquireFence();
+    if (vkQueueSubmit(m_queue, 1, &submitInfo, fence) != VK_SUCCESS) {
+        m_freeFences.push_back(fence);
+        throw std::runtime_error("failed to submit to queue timeline!");
+    }
+    m_pendingFences.push_back({value, fence});
+    m_submittedValue.store(value, std::memory_order_release);
+    return value;
+}
+
+VkResult QueueTimeline::present(const VkPresentInfoKHR& presentInfo) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return vkQueuePresentKHR(m_queue, &presentInfo);
+}
+
+bool QueueTimeline::isComplete(uint64_t value) {
+    if (value <= completedValue())
+        return true;
+
+#ifdef VK_KHR_timeline_semaphore
+    if (m_semaphore != VK_NULL_HANDLE) {
+        uint64_t counterValue = 0;
+        if (m_getSemaphoreCounterValue(m_device.device(), m_semaphore, &counterValue) != VK_SUCCESS)
+            throw std::runtime_error("failed to query timeline semaphore!");
+        updateCompletedValue(counterValue);
+        return value <= counterValue;
+    }
+#endif
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    retireFences();
+    return value <= completedValue();
+}
+
+void QueueTimeline::wait(uint64_t value) {
+    if (value <= completedValue())
+        return;
+    TRACE_ZONE("QueueTimeline::wait");
+
+#ifdef VK_KHR_timeline_semaphore
+    if (m_semaphore != VK_NULL_HANDLE) {
+        // Doesn't take the lock, other threads keep submitting while this one waits
+        VkSemaphoreWaitInfoKHR waitInfo = {};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &m_semaphore;
+        waitInfo.pValues = &value;
+        if (m_waitSemaphores(m_device.device(), &waitInfo, std::numeric_limits<uint64_t>::max()) != VK_SUCCESS)
+            throw std::runtime_error("failed to wait for timeline semaphore!");
+        updateCompletedValue(value);
+        return;
+    }
+#endif
+
+    // The fence is waited on unlocked as well, so submit() and present() from other threads don't stall
+    // behind a whole frame. Its last waiter recycles it, retireFences() skips fences that are waited on.
+    VkFence fence = VK_NULL_HANDLE;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        retireFences();
+        if (value <= completedValue())
+            return;
+        for (const auto& pending : m_pendingFences) {
+            if (pending.value >= value) {
+                fence = pending.fence;
+                break;
+            }
+        }
+        m_waitedFences.push_back(fence);
+    }
+    const VkResult result = vkWaitForFences(m_device.device(), 1, &fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_waitedFences.erase(std::find(m_waitedFences.begin(), m_waitedFences.end(), fence));
+    const bool retired = std::none_of(m_pendingFences.begin(), m_pendingFences.end(),
+                                      [fence](const PendingFence& pending) { return pending.fence == fence; });
+    if (retired && std::find(m_waitedFences.begin(), m_waitedFences.end(), fence) == m_waitedFences.end())
+        m_freeFences.push_back(fence);
+    retireFences();
+    if (result != VK_SUCCESS)
+        throw std::runtime_error("failed to wait for queue timeline fence!");
+}
+
+void QueueTimeline::updateCompletedValue(uint64_t value) {
+    uint64_t completed = m_completedValue.load(std::memory_order_relaxed);
+    while (completed < value && !m_completedValue.compare_exchange_weak(completed, value, std::memory_order_release))
+        ;
+}
+
+void QueueTimeline::retireFences() {
+    while (!m_pendingFences.empty()) {
+        const auto pending = m_pendingFences.front();
+        if (vkGetFenceStatus(m_device.device(), pending.fence) != VK_SUCCESS)
+            break;
+        // One queue retires submissions in order, so every earlier value is complete as well
+        updateCompletedValue(pending.value);
+        if (std::find(m_waitedFences.begin(), m_waitedFences.end(), pending.fence) == m_waitedFences.end())
+            m_freeFences.push_back(pending.fence);
+        m_pendingFences.pop_front();
+    }
+}
+
+VkFence QueueTimeline::acquireFence() {
+    if (!m_freeFences.empty()) {
+        VkFence fence = m_freeFences.back();
+        m_freeFences.pop_back();
+        vkResetFences(m_device.device(), 1, &fence);
+        return fence;
+    }
+
+    VkFence fence;
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    if (vkCreateFence(m_device.device(), &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+        throw std::runtime_error("failed to create fence!");
+    return fence;
+}
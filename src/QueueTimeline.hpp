@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+class VkDeviceWrap;
+
+/// Monotonically increasing timeline of one queue. Every submission through it signals the next value,
+/// so "upload N is done" or "frame K retired" is a single value the host can poll or wait on.
+/// Backed by a VK_KHR_timeline_semaphore semaphore when the device has it enabled, otherwise by a pool
+/// of fences, one per submission in flight, which are recycled and never allocated per wait.
+class QueueTimeline {
+public:
+    QueueTimeline(const VkDeviceWrap& device, VkQueue queue);
+
+    QueueTimeline(const QueueTimeline&) = delete;
+    QueueTimeline& operator=(const QueueTimeline&) = delete;
+
+    // Waits until everything submitted through the timeline has completed
+    ~QueueTimeline();
+
+    VkQueue queue() const { return m_queue; }
+    bool usesTimelineSemaphore() const { return m_semaphore != VK_NULL_HANDLE; }
+
+    // Thread safe. Signal semaphores of submitInfo are kept, returns the value signaled once the batch completes.
+    uint64_t submit(const VkSubmitInfo& submitInfo);
+    // Thread safe, takes the same lock as submit() since both need the queue externally synchronized.
+    // Presentation isn't a submission, it signals no timeline value.
+    VkResult present(const VkPresentInfoKHR& presentInfo);
+    // Values up to lastSubmittedValue() are valid, 0 is always complete
+    bool isComplete(uint64_t value);
+    void wait(uint64_t value);
+    void waitIdle() { wait(lastSubmittedValue()); }
+
+    uint64_t lastSubmittedValue() const { return m_submittedValue.load(std::memory_order_acquire); }
+    // Last value known to be complete, doesn't query the driver
+    uint64_t completedValue() const { return m_completedValue.load(std::memory_order_acquire); }
+
+private:
+    struct PendingFence {
+        uint64_t value;
+        VkFence fence;
+    };
+
+    const VkDeviceWrap& m_device;
+    VkQueue m_queue;
+    VkSemaphore m_semaphore = VK_NULL_HANDLE;
+    std::mutex m_mutex;
+    std::atomic<uint64_t> m_submittedValue {0};
+    std::atomic<uint64_t> m_completedValue {0};
+    // Reused by submit() so a submission doesn't allocate
+    std::vector<VkSemaphore> m_signalSemaphores;
+    std::vector<uint64_t> m_signalValues;
+    // Fence fallback, pending fences are in value order
+    std::deque<PendingFence> m_pendingFences;
+    std::vector<VkFence> m_freeFences;
+    std::vector<VkFence> m_waitedFences; // Waited on by wait() without the lock, once per waiting thread
+#ifdef VK_KHR_timeline_semaphore
+    PFN_vkGetSemaphoreCounterValueKHR m_getSemaphoreCounterValue = nullptr;
+    PFN_vkWaitSemaphoresKHR m_waitSemaphores = nullptr;
+#endif
+
+    void updateCompletedValue(uint64_t value);
+    // Fence fallback, called with m_mutex held, retires the signaled fences in value order
+    void retireFences();
+    VkFence acquireFence();
+};
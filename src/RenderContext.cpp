@@ -0,0 +1,345 @@
+#include "RenderContext.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "VulkanUtils.hpp"
+#include "CpuTracer.hpp"
+
+namespace {
+
+// Current SDKs ship every check in this one layer
+const std::vector<const char*> khronosValidationLayerNames = {"VK_LAYER_KHRONOS_validation"};
+
+// Split layers of SDKs older than 1.1.106, used when the Khronos layer is missing
+const std::vector<const char*> legacyValidationLayerNames = {
+    "VK_LAYER_LUNARG_standard_validation",
+    "VK_LAYER_LUNARG_parameter_validation",
+    "VK_LAYER_LUNARG_core_validation",
+    "VK_LAYER_LUNARG_object_tracker",
+    "VK_LAYER_GOOGLE_threading",
+    "VK_LAYER_GOOGLE_unique_objects"
+};
+
+// VK_KHR_surface is an instance extension, strict drivers reject it at device creation
+const std::vector<const char*> deviceRequiredExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+
+std::unique_ptr<Platform> createPlatformVerbose(const PlatformSettings& settings,
+                                                Platform::Handler updateHandler,
+                                                Platform::Handler resizeHandler) {
+    auto platform = createPlatform(settings, updateHandler, resizeHandler);
+    std::cout << "Platform: " << platform->name() << std::endl;
+    return platform;
+}
+
+// Validation is on only when the loader has some of the layers, the device enables the same list
+std::vector<const char*> enabledLayerNames(const RenderContextSettings& settings) {
+#if TESTAPP_VALIDATION
+    if (!settings.validation) {
+        std::cout << "Validation layers: off" << std::endl;
+        return {};
+    }
+    const auto& requiredLayerNames = validationLayersAvaliable(getVkValidationLayers(), khronosValidationLayerNames)
+        ? khronosValidationLayerNames
+        : legacyValidationLayerNames;
+    auto layerNames = findAvailableLayerNames(requiredLayerNames);
+    if (layerNames.empty()) {
+        std::cout << "None of the validation layers is available, validation is off" << std::endl;
+        return {};
+    }
+    std::cout << "Validation layers:" << std::endl;
+    for (auto layerName : layerNames)
+        std::cout << '\t' << layerName << std::endl;
+    return layerNames;
+#else
+    if (settings.validation)
+        std::cout << "Validation is compiled out, configure with -DTESTAPP_VALIDATION=ON to enable it" << std::endl;
+    return {};
+#endif
+}
+
+std::unique_ptr<DebugMessageSink> createDebugMessageSink(const std::vector<const char*>& layerNames,
+                                                         const RenderContextSettings& settings) {
+    if (layerNames.empty())
+        return nullptr;
+    return std::make_unique<DebugMessageSink>(std::cout, settings.debugPrintSeverity);
+}
+
+// Runs inside driver calls, so it only copies the message out, printing happens on the sink thread
+VkInstanceWrap::DebugCallback debugCallback(DebugMessageSink* debugMessages) {
+    if (debugMessages == nullptr)
+        return nullptr;
+    return [debugMessages](VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
+                           VkDebugUtilsMessageTypeFlagsEXT messageType,
+                           const VkDebugUtilsMessengerCallbackDataEXT& pCallbackData) {
+        debugMessages->push(messageSeverity, messageType, pCallbackData);
+    };
+}
+
+std::vector<const char*> instanceExtensionNames(const Platform& platform, bool validation) {
+    auto requiredInstanceExtensionNames = platform.requiredInstanceExtensions();
+    if (validation)
+        requiredInstanceExtensionNames.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+    // Timeline semaphores depend on it under Vulkan 1.0, without it queue timelines fall back to fences
+    if (instanceExtensionAvailable(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME))
+        requiredInstanceExtensionNames.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+    std::cout << "Required extensions for instance:" << std::endl;
+    for (auto requiredExtensionName : requiredInstanceExtensionNames)
+        std::cout << '\t' << requiredExtensionName << std::endl;
+    return requiredInstanceExtensionNames;
+}
+
+VkInstanceWrap createVkInstance(const std::vector<const char*>& requiredExtensionNames,
+                            const std::vector<const char*>& validationLayerNames,
+                            VkInstanceWrap::DebugCallback debugCallback) {
+    TRACE_ZONE("createVkInstance");
+    std::cout << "available extensions:" << std::endl;
+    for (const auto& extension : getVkExtensions())
+        std::cout << '\t' << extension.extensionName << std::endl;
+    
+    VkApplicationInfo appInfo = {};
+    appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    appInfo.pApplicationName = "Hello Triangle";
+    appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+    appInfo.pEngineName = "FlappyEngine";
+    appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+    appInfo.apiVersion = VK_API_VERSION_1_0;
+
+    return VkInstanceWrap(requiredExtensionNames, validationLayerNames, appInfo, std::move(debugCallback));
+}
+
+VkDeviceWrap createVkLogicalDevice(const VkPhysicalDeviceWrap& physicalDevice,
+                               const std::vector<const char*>& validationLayerNames,
+                               const std::vector<const char*>& extensionNames) {
+    TRACE_ZONE("createVkLogicalDevice");
+    // Common for all queues
+    float queuePriority = 1.0f;
+
+    // Queues
+    std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+    for (auto familyIndex : physicalDevice.queueFamilies().uniqueIndices()){
+        VkDeviceQueueCreateInfo& queueCreateInfo = queueCreateInfos.emplace_back();
+        queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+        queueCreateInfo.queueFamilyIndex = familyIndex;
+        queueCreateInfo.queueCount = 1;
+        queueCreateInfo.pQueuePriorities = &queuePriority;
+    }
+    
+    VkPhysicalDeviceFeatures features {};
+    
+    auto enabledExtensionNames = extensionNames;
+    const void* featureChain = nullptr;
+#ifdef VK_KHR_timeline_semaphore
+    // Every device exposing the extension supports the feature
+    VkPhysicalDeviceTimelineSemaphoreFeaturesKHR timelineFeatures = {};
+    timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR;
+    timelineFeatures.timelineSemaphore = VK_TRUE;
+    if (physicalDevice.capabilities().hasExtension(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME)
+        && instanceExtensionAvailable(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME)) {
+        enabledExtensionNames.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+        featureChain = &timelineFeatures;
+    }
+#endif
+
+    return VkDeviceWrap(physicalDevice, features, validationLayerNames, queueCreateInfos, enabledExtensionNames, featureChain);
+}
+
+VkQueue getVkQueue(VkDevice device, unsigned family, unsigned index) {
+    VkQueue queue;
+    vkGetDeviceQueue(device, family, index, &queue);
+    return queue;
+}
+
+VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats) {
+    if (availableFormats.size() == 1 && availableFormats[0].format == VK_FORMAT_UNDEFINED)
+        return {VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR};
+
+    for (const auto& availableFormat : availableFormats) {
+        if (availableFormat.format == VK_FORMAT_B8G8R8A8_UNORM && availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
+            return availableFormat;
+    }
+
+    return availableFormats[0];
+}
+
+VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR> availablePresentModes) {
+    VkPresentModeKHR bestMode = VK_PRESENT_MODE_FIFO_KHR;
+
+    for (const auto& availablePresentMode : availablePresentModes) {
+        if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+            return availablePresentMode;
+        else if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR)
+            bestMode = availablePresentMode;
+    }
+
+    return bestMode;
+}
+
+VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, const VkExtent2D& windowExtent) {
+    if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
+        return capabilities.currentExtent;
+    } else {
+        VkExtent2D actualExtent = windowExtent;
+
+        actualExtent.width = std::max(capabilities.minImageExtent.width, std::min(capabilities.maxImageExtent.width, actualExtent.width));
+        actualExtent.height = std::max(capabilities.minImageExtent.height, std::min(capabilities.maxImageExtent.height, actualExtent.height));
+
+        return actualExtent;
+    }
+}
+
+uint32_t selectImageCount(const SwapChainSupportDetails& swapChainSupport) {
+    uint32_t imageCount = swapChainSupport.capabilities.minImageCount;
+    // A value of 0 for maxImageCount means that there is no limit besides memory requirements,
+    // which is why we need to check for that.
+    if (swapChainSupport.capabilities.maxImageCount > 0 && imageCount > swapChainSupport.capabilities.maxImageCount) {
+        imageCount = swapChainSupport.capabilities.maxImageCount;
+    }
+
+    return imageCount;
+}
+
+VkPipelineLayout createPipelineLayout(VkDevice device) {
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 0; // Optional
+    pipelineLayoutInfo.pSetLayouts = nullptr; // Optional
+    pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
+    pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
+
+    VkPipelineLayout pipelineLayout;
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline layout!");
+    }
+
+    return pipelineLayout;
+}
+
+VkRenderPass createRenderPass(VkDevice device, VkFormat imageFormat) {
+    VkAttachmentDescription colorAttachment = {};
+    colorAttachment.flags = 0;
+    colorAttachment.format = imageFormat;
+    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+    VkAttachmentReference colorAttachmentRef = {};
+    colorAttachmentRef.attachment = 0;
+    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkSubpassDescription subpass = {};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorAttachmentRef;
+
+    VkSubpassDependency dependency = {};
+    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependency.dstSubpass = 0;
+    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.srcAccessMask = 0;
+    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+    VkRenderPassCreateInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = 1;
+    renderPassInfo.pAttachments = &colorAttachment;
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+    renderPassInfo.dependencyCount = 1;
+    renderPassInfo.pDependencies = &dependency;
+
+    VkRenderPass renderPass;
+    if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create render pass!");
+    }
+
+    return renderPass;
+}
+
+void printQueueFamilies(const QueueFamilyIndices& queueFamilies) {
+    std::cout << "Graphics family index: " << queueFamilies.graphicsFamily << std::endl;
+    std::cout << "Present family index: " << queueFamilies.presentFamily << std::endl;
+    std::cout << "Transfer family index: " << queueFamilies.transferFamily
+              << (queueFamilies.hasDedicatedTransfer() ? " (dedicated)" : " (shared)") << std::endl;
+    std::cout << "Compute family index: " << queueFamilies.computeFamily
+              << (queueFamilies.hasDedicatedCompute() ? " (dedicated)" : " (shared)") << std::endl;
+}
+
+} // namespace
+
+RenderContext::RenderContext(const RenderContextSettings& settings,
+                             Platform::Handler updateHandler,
+                             Platform::Handler resizeHandler)
+    : m_platform(createPlatformVerbose(settings.platform, updateHandler, resizeHandler))
+    , m_layerNames(enabledLayerNames(settings))
+    , m_debugMessages(createDebugMessageSink(m_layerNames, settings))
+    , m_instance(createVkInstance(instanceExtensionNames(*m_platform, validation()),
+                                  m_layerNames,
+                                  debugCallback(m_debugMessages.get())))
+    , m_surface(m_platform->createSurface(m_instance.instance()), m_instance)
+    , m_physicalDevice(m_instance.findCompatibleDevice(m_surface, deviceRequiredExtensions, settings.gpu))
+    , m_device(createVkLogicalDevice(m_physicalDevice, m_layerNames, deviceRequiredExtensions))
+    , m_pipelineCache(m_device, settings.pipelineCachePath, settings.coldPipelineCache)
+    , m_pipelineRegistry(m_device.device(), m_pipelineCache.pipelineCache(), m_jobSystem)
+    , m_shaderLibrary(m_device.device())
+{
+    const auto& queueFamilies = m_physicalDevice.queueFamilies();
+    printQueueFamilies(queueFamilies);
+    
+    SwapchainSettings swapchainSettings {
+        .surfaceFormat = chooseSwapSurfaceFormat(m_physicalDevice.supportDetails().formats),
+        .presentMode = chooseSwapPresentMode(m_physicalDevice.supportDetails().presentModes),
+        .extent = chooseSwapExtent(m_physicalDevice.supportDetails().capabilities, m_platform->windowExtent()),
+        .imageCount = selectImageCount(m_physicalDevice.supportDetails()),
+        .transform = m_physicalDevice.supportDetails().capabilities.currentTransform
+    };
+    
+    m_pipelineLayout = createPipelineLayout(m_device.device());
+    m_renderPass = createRenderPass(m_device.device(), swapchainSettings.surfaceFormat.format);
+    m_swapchain = std::make_unique<SwapchainResources>(m_device, m_surface, m_renderPass, swapchainSettings);
+    
+    // All shaders are mapped in one pass, every pipeline variant refers to the same modules
+    m_shaderLibrary.loadDirectory(settings.shaderDirectory);
+    std::cout << "Shader modules: " << m_shaderLibrary.moduleCount() << std::endl;
+    
+    m_graphicsQueue = getVkQueue(m_device.device(), queueFamilies.graphicsFamily, 0);
+    m_presentQueue = getVkQueue(m_device.device(), queueFamilies.presentFamily, 0);
+    m_transferQueue = getVkQueue(m_device.device(), queueFamilies.transferFamily, 0);
+    
+    // One timeline per queue, a shared queue has to share its timeline as well
+    m_graphicsTimeline = std::make_unique<QueueTimeline>(m_device, m_graphicsQueue);
+    if (m_transferQueue != m_graphicsQueue)
+        m_transferTimeline = std::make_unique<QueueTimeline>(m_device, m_transferQueue);
+    if (m_presentQueue != m_graphicsQueue && m_presentQueue != m_transferQueue)
+        m_presentTimeline = std::make_unique<QueueTimeline>(m_device, m_presentQueue);
+    std::cout << "Queue timelines: " << (m_graphicsTimeline->usesTimelineSemaphore() ? "timeline semaphores" : "fence pool")
+              << std::endl;
+    
+    // Streaming uploads run on the transfer queue and overlap rendering when the family is dedicated
+    m_uploadQueue = std::make_unique<UploadQueue>(m_device,
+                                                  queueFamilies.transferFamily, transferTimeline(),
+                                                  queueFamilies.graphicsFamily, graphicsTimeline());
+}
+
+RenderContext::~RenderContext() {
+    vkDeviceWaitIdle(m_device.device());
+    
+    m_uploadQueue.reset();
+    m_swapchain.reset();
+    vkDestroyRenderPass(m_device.device(), m_renderPass, nullptr);
+    vkDestroyPipelineLayout(m_device.device(), m_pipelineLayout, nullptr);
+}
+
+QueueTimeline& RenderContext::presentTimeline() {
+    if (m_presentTimeline != nullptr)
+        return *m_presentTimeline;
+    return m_presentQueue == m_transferQueue ? transferTimeline() : graphicsTimeline();
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Platform.hpp"
+#include "DebugMessageSink.hpp"
+#include "VkInstanceWrap.hpp"
+#include "VkSurfaceWrap.hpp"
+#include "VkPhysicalDeviceWrap.hpp"
+#include "VkDeviceWrap.hpp"
+#include "SwapchainResources.hpp"
+#include "VkPipelineCacheWrap.hpp"
+#include "JobSystem.hpp"
+#include "PipelineRegistry.hpp"
+#include "ShaderLibrary.hpp"
+#include "UploadQueue.hpp"
+#include "QueueTimeline.hpp"
+
+struct RenderContextSettings {
+    PlatformSettings platform;
+    std::string pipelineCachePath = "pipeline_cache.bin";
+    bool coldPipelineCache = false;
+    std::string shaderDirectory = "shaders";
+    // Device index or part of its name, empty picks the highest ranked device
+    std::string gpu;
+    // Validation layers run by default in unoptimized builds only, ignored when compiled out
+#if TESTAPP_VALIDATION && !defined(NDEBUG)
+    bool validation = true;
+#else
+    bool validation = false;
+#endif
+    // Lower severities are only counted
+    VkDebugUtilsMessageSeverityFlagBitsEXT debugPrintSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT;
+};
+
+/// Vulkan objects shared by every frontend (app and benchmarks), created in dependency order
+/// and destroyed in reverse. Scenes and renderers are built on top of it.
+class RenderContext {
+public:
+    RenderContext(const RenderContextSettings& settings, Platform::Handler updateHandler, Platform::Handler resizeHandler);
+
+    RenderContext(const RenderContext&) = delete;
+    RenderContext& operator=(const RenderContext&) = delete;
+
+    // Waits until the device is idle
+    ~RenderContext();
+
+    Platform& platform() { return *m_platform; }
+    const VkInstanceWrap& instance() const { return m_instance; }
+    // True when some validation layer was actually enabled, not just asked for
+    bool validation() const { return !m_layerNames.empty(); }
+    // Null when validation is off
+    DebugMessageSink* debugMessages() { return m_debugMessages.get(); }
+    const DebugMessageSink* debugMessages() const { return m_debugMessages.get(); }
+    const VkPhysicalDeviceWrap& physicalDevice() const { return m_physicalDevice; }
+    const VkDeviceWrap& device() const { return m_device; }
+    VkRenderPass renderPass() const { return m_renderPass; }
+    VkPipelineLayout pipelineLayout() const { return m_pipelineLayout; }
+    SwapchainResources& swapchain() { return *m_swapchain; }
+    VkPipelineCacheWrap& pipelineCache() { return m_pipelineCache; }
+    JobSystem& jobSystem() { return m_jobSystem; }
+    PipelineRegistry& pipelineRegistry() { return m_pipelineRegistry; }
+    ShaderLibrary& shaderLibrary() { return m_shaderLibrary; }
+    UploadQueue& uploadQueue() { return *m_uploadQueue; }
+    VkQueue graphicsQueue() const { return m_graphicsQueue; }
+    VkQueue presentQueue() const { return m_presentQueue; }
+    QueueTimeline& graphicsTimeline() { return *m_graphicsTimeline; }
+    QueueTimeline& transferTimeline() { return m_transferTimeline != nullptr ? *m_transferTimeline : *m_graphicsTimeline; }
+    // Timeline of the queue presentation goes to, present through it so it doesn't race submissions
+    QueueTimeline& presentTimeline();
+
+private:
+    std::unique_ptr<Platform> m_platform;
+    std::vector<const char*> m_layerNames; // Enabled on the instance and the device, empty when validation is off
+    std::unique_ptr<DebugMessageSink> m_debugMessages; // Outlives the instance, its messenger reports until vkDestroyInstance
+    VkInstanceWrap m_instance;
+    VkSurfaceWrap m_surface;
+    VkPhysicalDeviceWrap m_physicalDevice;
+    VkDeviceWrap m_device;
+    VkRenderPass m_renderPass;
+    VkPipelineLayout m_pipelineLayout;
+    std::unique_ptr<SwapchainResources> m_swapchain;
+    VkPipelineCacheWrap m_pipelineCache;
+    JobSystem m_jobSystem;
+    PipelineRegistry m_pipelineRegistry;
+    ShaderLibrary m_shaderLibrary;
+    VkQueue m_graphicsQueue;
+    VkQueue m_presentQueue;
+    VkQueue m_transferQueue;
+    std::unique_ptr<QueueTimeline> m_graphicsTimeline;
+    std::unique_ptr<QueueTimeline> m_transferTimeline; // Null when transfers share the graphics queue
+    std::unique_ptr<QueueTimeline> m_presentTimeline; // Null when presentation shares a queue of the other two
+    std::unique_ptr<UploadQueue> m_uploadQueue;
+};
@@ -0,0 +1,259 @@
+#include "RenderTargetPool.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <stdexcept>
+
+#include "VkDeviceWrap.hpp"
+#include "CpuTracer.hpp"
+
+namespace {
+
+VkImageAspectFlags aspectMask(VkFormat format) {
+    switch (format) {
+    case VK_FORMAT_D16_UNORM:
+    case VK_FORMAT_X8_D24_UNORM_PACK32:
+    case VK_FORMAT_D32_SFLOAT:
+        return VK_IMAGE_ASPECT_DEPTH_BIT;
+    case VK_FORMAT_S8_UINT:
+        return VK_IMAGE_ASPECT_STENCIL_BIT;
+    case VK_FORMAT_D16_UNORM_S8_UINT:
+    case VK_FORMAT_D24_UNORM_S8_UINT:
+    case VK_FORMAT_D32_SFLOAT_S8_UINT:
+        return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+    default:
+        return VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+}
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+double toMiB(VkDeviceSize bytes) {
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+} // namespace
+
+bool AliasedRange::overlaps(const AliasedRange& other) const {
+    for (const auto& lifetime : lifetimes) {
+        for (const auto& otherLifetime : other.lifetimes) {
+            if (lifetime.overlaps(otherLifetime))
+                return true;
+        }
+    }
+    return false;
+}
+
+VkDeviceSize planAliasing(const std::vector<AliasedRange*>& ranges) {
+    std::vector<AliasedRange*> order = ranges;
+    std::stable_sort(order.begin(), order.end(), [](const AliasedRange* a, const AliasedRange* b) {
+        return a->size > b->size;
+    });
+
+    VkDeviceSize peak = 0;
+    std::vector<const AliasedRange*> placed;
+    std::vector<const AliasedRange*> conflicts;
+    for (auto* range : order) {
+        conflicts.clear();
+        for (const auto* other : placed) {
+            if (range->overlaps(*other))
+                conflicts.push_back(other);
+        }
+        std::sort(conflicts.begin(), conflicts.end(), [](const AliasedRange* a, const AliasedRange* b) {
+            return a->offset < b->offset;
+        });
+
+        VkDeviceSize offset = 0;
+        for (const auto* other : conflicts) {
+            if (offset + range->size <= other->offset)
+                break;
+            offset = std::max(offset, alignUp(other->offset + other->size, range->alignment));
+        }
+
+        range->offset = offset;
+        placed.push_back(range);
+        peak = std::max(peak, offset + range->size);
+    }
+    return peak;
+}
+
+RenderTargetPool::RenderTargetPool(const VkDeviceWrap& device)
+    : m_device(device)
+{
+}
+
+RenderTargetPool::~RenderTargetPool() {
+    clear();
+}
+
+RenderTargetHandle RenderTargetPool::request(const RenderTargetDesc& desc, uint32_t firstPass, uint32_t lastPass) {
+    if (m_built)
+        throw std::runtime_error("render target requested after the pool was built!");
+    if (firstPass > lastPass)
+        throw std::runtime_error("render target lifetime ends before it begins!");
+
+    Request request;
+    request.desc = desc;
+    request.lifetime = {firstPass, lastPass};
+    m_requests.push_back(request);
+    return static_cast<RenderTargetHandle>(m_requests.size() - 1);
+}
+
+void RenderTargetPool::build() {
+    TRACE_ZONE("RenderTargetPool::build");
+    if (m_built)
+        throw std::runtime_error("render target pool is already built!");
+    m_built = true;
+
+    // Requests with the same descriptor that never live at the same time share one image
+    for (auto& request : m_requests) {
+        auto imageIt = std::find_if(m_images.begin(), m_images.end(), [&request](const Image& image) {
+            const auto& lifetimes = image.range.lifetimes;
+            return image.desc == request.desc
+                   && std::none_of(lifetimes.begin(), lifetimes.end(),
+                                   [&request](const RenderTargetLifetime& lifetime) { return lifetime.overlaps(request.lifetime); });
+        });
+        if (imageIt == m_images.end()) {
+            Image image;
+            image.desc = request.desc;
+            m_images.push_back(image);
+            imageIt = m_images.end() - 1;
+        }
+        imageIt->range.lifetimes.push_back(request.lifetime);
+        request.imageIndex = static_cast<uint32_t>(imageIt - m_images.begin());
+    }
+
+    m_stats = {};
+    m_stats.requestCount = m_requests.size();
+    m_stats.imageCount = m_images.size();
+    for (auto& image : m_images)
+        createImage(image);
+    for (const auto& request : m_requests)
+        m_stats.naiveBytes += m_images[request.imageIndex].requirements.size;
+
+    auto& allocator = m_device.memoryAllocator();
+    for (auto& image : m_images) {
+        if (!image.lazy)
+            continue;
+        // Lazily allocated memory has no backing to share on tiled GPUs, every image gets its own
+        VkMemoryRequirements requirements = image.requirements;
+        requirements.memoryTypeBits = 1u << image.memoryTypeIndex;
+        image.allocationIndex = m_allocations.size();
+        m_allocations.push_back(allocator.allocateDedicated(requirements, 0));
+        ++m_stats.lazyImageCount;
+        m_stats.lazyBytes += image.requirements.size;
+    }
+
+    std::vector<bool> planned(m_images.size(), false);
+    for (size_t i = 0; i < m_images.size(); ++i) {
+        if (m_images[i].lazy || planned[i])
+            continue;
+
+        // Images of one memory type share one allocation
+        std::vector<AliasedRange*> group;
+        for (size_t j = i; j < m_images.size(); ++j) {
+            if (!m_images[j].lazy && m_images[j].memoryTypeIndex == m_images[i].memoryTypeIndex) {
+                group.push_back(&m_images[j].range);
+                m_images[j].allocationIndex = m_allocations.size();
+                planned[j] = true;
+            }
+        }
+
+        VkMemoryRequirements requirements = {};
+        requirements.size = planAliasing(group);
+        requirements.alignment = 1;
+        requirements.memoryTypeBits = 1u << m_images[i].memoryTypeIndex;
+        m_allocations.push_back(allocator.allocateDedicated(requirements, 0));
+        m_stats.aliasedBytes += requirements.size;
+    }
+
+    for (auto& image : m_images) {
+        const MemoryAllocation& allocation = m_allocations[image.allocationIndex];
+        if (vkBindImageMemory(m_device.device(), image.image, allocation.deviceMemory, allocation.offset + image.range.offset) != VK_SUCCESS)
+            throw std::runtime_error("failed to bind render target memory!");
+
+        VkImageViewCreateInfo viewInfo = {};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image.image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = image.desc.format;
+        viewInfo.subresourceRange.aspectMask = aspectMask(image.desc.format);
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+        if (vkCreateImageView(m_device.device(), &viewInfo, nullptr, &image.imageView) != VK_SUCCESS)
+            throw std::runtime_error("failed to create render target view!");
+    }
+}
+
+void RenderTargetPool::clear() {
+    // Frames still in flight may be using the targets, views and images go before the memory under them
+    auto& deletionQueue = m_device.deletionQueue();
+    for (const auto& image : m_images) {
+        if (image.imageView != VK_NULL_HANDLE)
+            deletionQueue.destroyImageView(image.imageView);
+        if (image.image != VK_NULL_HANDLE)
+            deletionQueue.destroyImage(image.image);
+    }
+    for (const auto& allocation : m_allocations)
+        deletionQueue.freeMemory(m_device.memoryAllocator(), allocation);
+
+    m_requests.clear();
+    m_images.clear();
+    m_allocations.clear();
+    m_stats = {};
+    m_built = false;
+}
+
+void RenderTargetPool::createImage(Image& image) {
+    const auto& capabilities = m_device.physicalDevice().capabilities();
+
+    VkImageCreateInfo imageInfo = {};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = image.desc.format;
+    imageInfo.extent = {image.desc.extent.width, image.desc.extent.height, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = image.desc.usage;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (vkCreateImage(m_device.device(), &imageInfo, nullptr, &image.image) != VK_SUCCESS)
+        throw std::runtime_error("failed to create render target!");
+    vkGetImageMemoryRequirements(m_device.device(), image.image, &image.requirements);
+    image.range.size = image.requirements.size;
+    image.range.alignment = image.requirements.alignment;
+
+    if (image.desc.usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) {
+        image.memoryTypeIndex = capabilities.findMemoryType(image.requirements.memoryTypeBits,
+                                                            VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+        image.lazy = image.memoryTypeIndex != PhysicalDeviceCapabilities::NO_MEMORY_TYPE;
+        if (image.lazy)
+            return;
+    }
+    image.memoryTypeIndex = capabilities.findMemoryType(image.requirements.memoryTypeBits,
+                                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (image.memoryTypeIndex == PhysicalDeviceCapabilities::NO_MEMORY_TYPE)
+        throw std::runtime_error("failed to find device local memory for render target!");
+}
+
+void printRenderTargetStats(std::ostream& stream, const RenderTargetStats& stats) {
+    const auto flags = stream.flags();
+    const auto precision = stream.precision();
+    const VkDeviceSize bound = stats.aliasedBytes + stats.lazyBytes;
+    stream << std::fixed << std::setprecision(2);
+    stream << "Render targets: " << stats.requestCount << " requests, " << stats.imageCount << " images, "
+           << stats.lazyImageCount << " lazily allocated" << std::endl;
+    stream << "  naive:   " << toMiB(stats.naiveBytes) << " MiB" << std::endl;
+    stream << "  aliased: " << toMiB(stats.aliasedBytes) << " MiB peak + " << toMiB(stats.lazyBytes) << " MiB lazy";
+    if (stats.naiveBytes > 0)
+        stream << " (" << 100.0 * static_cast<double>(bound) / static_cast<double>(stats.naiveBytes) << "% of naive)";
+    stream << std::endl;
+    stream.flags(flags);
+    stream.precision(precision);
+}
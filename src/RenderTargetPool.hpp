@@ -0,0 +1,113 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "VkMemoryAllocator.hpp"
+
+class VkDeviceWrap;
+
+struct RenderTargetDesc {
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkExtent2D extent = {0, 0};
+    // With VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT the target goes to lazily allocated memory where the device has it
+    VkImageUsageFlags usage = 0;
+
+    bool operator==(const RenderTargetDesc& other) const {
+        return format == other.format && extent.width == other.extent.width
+               && extent.height == other.extent.height && usage == other.usage;
+    }
+};
+
+using RenderTargetHandle = uint32_t;
+
+// Passes are numbered in recording order, lastPass is inclusive
+struct RenderTargetLifetime {
+    uint32_t firstPass;
+    uint32_t lastPass;
+
+    bool overlaps(const RenderTargetLifetime& other) const { return firstPass <= other.lastPass && other.firstPass <= lastPass; }
+};
+
+// Memory of one image in an aliasing plan, an image reused by several requests lives in several ranges of passes
+struct AliasedRange {
+    VkDeviceSize size = 0;
+    VkDeviceSize alignment = 1;
+    std::vector<RenderTargetLifetime> lifetimes;
+    VkDeviceSize offset = 0; // Assigned by planAliasing()
+
+    bool overlaps(const AliasedRange& other) const;
+};
+
+// Places ranges largest first, each at the lowest aligned offset not taken by a range alive at the same time.
+// Returns the size of the allocation they need together. Meant for optimally tiled images only, which
+// bufferImageGranularity never separates from each other.
+VkDeviceSize planAliasing(const std::vector<AliasedRange*>& ranges);
+
+struct RenderTargetStats {
+    size_t requestCount = 0;
+    size_t imageCount = 0;          // Requests with equal descriptors and disjoint lifetimes share an image
+    size_t lazyImageCount = 0;
+    VkDeviceSize naiveBytes = 0;    // Every request in memory of its own
+    VkDeviceSize aliasedBytes = 0;  // Device memory actually bound, the peak of the aliasing plan
+    VkDeviceSize lazyBytes = 0;     // Requirements of lazily allocated images, committed only if the driver needs to
+};
+
+/// Frame-local render targets (depth, HDR color, post-processing chains) handed out by descriptor.
+/// Every request names the first and last pass of the frame using it. build() gives requests with equal
+/// descriptors and disjoint lifetimes the same image, and places images whose lifetimes don't overlap at
+/// overlapping offsets of one allocation per memory type. Contents don't survive outside the requested
+/// passes, so the first use of a target has to transition it from VK_IMAGE_LAYOUT_UNDEFINED.
+class RenderTargetPool {
+public:
+    explicit RenderTargetPool(const VkDeviceWrap& device);
+
+    RenderTargetPool(const RenderTargetPool&) = delete;
+    RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+    ~RenderTargetPool();
+
+    // Lifetime as in RenderTargetLifetime
+    RenderTargetHandle request(const RenderTargetDesc& desc, uint32_t firstPass, uint32_t lastPass);
+    // Creates images, plans aliasing and binds memory for everything requested so far
+    void build();
+    // Releases images and memory through the deletion queue and forgets the requests, e.g. before a resize
+    void clear();
+
+    VkImage image(RenderTargetHandle handle) const { return m_images[m_requests[handle].imageIndex].image; }
+    VkImageView imageView(RenderTargetHandle handle) const { return m_images[m_requests[handle].imageIndex].imageView; }
+    const RenderTargetDesc& desc(RenderTargetHandle handle) const { return m_requests[handle].desc; }
+    const RenderTargetStats& stats() const { return m_stats; }
+
+private:
+    struct Request {
+        RenderTargetDesc desc;
+        RenderTargetLifetime lifetime;
+        uint32_t imageIndex = 0;
+    };
+
+    struct Image {
+        RenderTargetDesc desc;
+        AliasedRange range; // Offset inside the allocation of its memory type
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView imageView = VK_NULL_HANDLE;
+        VkMemoryRequirements requirements = {};
+        uint32_t memoryTypeIndex = 0;
+        bool lazy = false;
+        size_t allocationIndex = 0;
+    };
+
+    const VkDeviceWrap& m_device;
+    std::vector<Request> m_requests;
+    std::vector<Image> m_images;
+    std::vector<MemoryAllocation> m_allocations;
+    RenderTargetStats m_stats;
+    bool m_built = false;
+
+    void createImage(Image& image);
+};
+
+void printRenderTargetStats(std::ostream& stream, const RenderTargetStats& stats);
@@ -0,0 +1,152 @@
+#include "Renderer.hpp"
+
+#include <limits>
+#include <stdexcept>
+
+#include "VkDeviceWrap.hpp"
+#include "SwapchainResources.hpp"
+#include "QueueTimeline.hpp"
+#include "CpuTracer.hpp"
+
+Renderer::Renderer(const VkDeviceWrap& device,
+                   SwapchainResources& swapchain,
+                   RecordFunc recordFunc,
+                   unsigned framesInFlight,
+                   QueueTimeline& graphicsTimeline,
+                   QueueTimeline& presentTimeline)
+    : m_device(device)
+    , m_swapchain(swapchain)
+    , m_recordFunc(std::move(recordFunc))
+    , m_graphicsTimeline(graphicsTimeline)
+    , m_frameRing(device, graphicsTimeline, framesInFlight, swapchain.imageCount())
+    , m_commandAllocator(device, device.physicalDevice().queueFamilies().graphicsFamily, framesInFlight)
+    , m_presentTimeline(presentTimeline)
+{
+}
+
+Renderer::~Renderer() {
+    m_frameRing.waitIdle();
+    // Frames are the only work that uses released objects and none is in flight anymore
+    m_device.deletionQueue().collectAll();
+}
+
+void Renderer::drawFrame() {
+    TRACE_ZONE("drawFrame");
+    if (m_resizeRequested.exchange(false) || !m_swapchainValid) {
+        if (!recreateSwapchain())
+            return;
+    }
+    
+    auto& frame = m_frameRing.beginFrame();
+    // Objects released before retired submissions go now, whatever is released from here on waits for this frame
+    m_device.deletionQueue().collect(m_graphicsTimeline.completedValue());
+    
+    uint32_t imageIndex;
+    VkResult acquireResult;
+    {
+        TRACE_ZONE("vkAcquireNextImageKHR");
+        acquireResult = vkAcquireNextImageKHR(m_device.device(),
+                                              m_swapchain.swapchain(),
+                                              std::numeric_limits<uint64_t>::max(),
+                                              frame.imageAvailableSemaphore,
+                                              VK_NULL_HANDLE, &imageIndex);
+    }
+    if (acquireResult == VK_ERROR_OUT_OF_DATE_KHR) {
+        // Nothing was signaled, the slot can be reused as is
+        m_swapchainValid = false;
+        return;
+    }
+    if (acquireResult != VK_SUCCESS && acquireResult != VK_SUBOPTIMAL_KHR)
+        throw std::runtime_error("failed to acquire swapchain image!");
+    m_frameRing.acquireImage(imageIndex);
+    
+    // Slot fence is signaled, so everything recorded from this slot N frames ago is retired
+    m_commandAllocator.reset(m_frameRing.currentIndex());
+    VkCommandBuffer commandBuffer = m_commandAllocator.allocate(m_frameRing.currentIndex());
+    
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin recording command buffer!");
+    }
+    {
+        TRACE_ZONE("record frame");
+        m_recordFunc(commandBuffer, m_swapchain.framebuffer(imageIndex), m_swapchain.extent(), m_frameRing.currentIndex());
+    }
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record command buffer!");
+    }
+    
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    
+    VkSemaphore waitSemaphores[] = {frame.imageAvailableSemaphore};
+    VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+    submitInfo.waitSemaphoreCount = 1;
+    submitInfo.pWaitSemaphores = waitSemaphores;
+    submitInfo.pWaitDstStageMask = waitStages;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    VkSemaphore signalSemaphores[] = {m_frameRing.renderFinishedSemaphore(imageIndex)};
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = signalSemaphores;
+    {
+        TRACE_ZONE("vkQueueSubmit");
+        m_frameRing.submit(submitInfo);
+    }
+    m_device.deletionQueue().stamp(frame.timelineValue);
+    
+    VkPresentInfoKHR presentInfo = {};
+    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    
+    presentInfo.waitSemaphoreCount = 1;
+    presentInfo.pWaitSemaphores = signalSemaphores;
+    
+    VkSwapchainKHR swapChains[] = {m_swapchain.swapchain()};
+    presentInfo.swapchainCount = 1;
+    presentInfo.pSwapchains = swapChains;
+    presentInfo.pImageIndices = &imageIndex;
+    presentInfo.pResults = nullptr;
+    VkResult presentResult;
+    {
+        TRACE_ZONE("vkQueuePresentKHR");
+        presentResult = m_presentTimeline.present(presentInfo);
+    }
+    if (presentResult != VK_SUCCESS && presentResult != VK_SUBOPTIMAL_KHR && presentResult != VK_ERROR_OUT_OF_DATE_KHR)
+        throw std::runtime_error("failed to present swapchain image!");
+    if (acquireResult == VK_SUBOPTIMAL_KHR || presentResult == VK_SUBOPTIMAL_KHR || presentResult == VK_ERROR_OUT_OF_DATE_KHR)
+        m_swapchainValid = false;
+    
+    m_frameRing.endFrame();
+}
+
+bool Renderer::recreateSwapchain() {
+    TRACE_ZONE("recreateSwapchain");
+    // Frames in flight keep rendering into the old swapchain, it is retired through the deletion queue
+    // instead of idling queues. Old image indices don't refer to new images, so the image slots start over.
+    m_swapchainValid = m_swapchain.recreate();
+    if (!m_swapchainValid)
+        return false;
+    
+    m_frameRing.resetImages(m_swapchain.imageCount());
+    return true;
+}
+
+void beginRenderPass(VkCommandBuffer commandBuffer,
+                     VkRenderPass renderPass,
+                     VkFramebuffer framebuffer,
+                     const VkExtent2D& extent,
+                     VkSubpassContents contents) {
+    VkRenderPassBeginInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = renderPass;
+    renderPassInfo.framebuffer = framebuffer;
+    renderPassInfo.renderArea.offset = {0, 0};
+    renderPassInfo.renderArea.extent = extent;
+    VkClearValue clearColor;
+    clearColor.color = {{0.0f, 0.0f, 0.0f, 1.0f}};
+    renderPassInfo.clearValueCount = 1;
+    renderPassInfo.pClearValues = &clearColor;
+    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+}
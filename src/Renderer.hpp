@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "FrameRing.hpp"
+#include "FrameCommandAllocator.hpp"
+
+class VkDeviceWrap;
+class SwapchainResources;
+class QueueTimeline;
+
+/// Owns everything the per-frame callback touches, so drawing a frame doesn't copy or allocate anything.
+class Renderer {
+public:
+    // Called every frame, records the whole frame between vkBeginCommandBuffer and vkEndCommandBuffer
+    // frameIndex identifies the FrameRing slot for per-frame resources of the caller
+    using RecordFunc = std::function<void(VkCommandBuffer commandBuffer,
+                                          VkFramebuffer framebuffer,
+                                          const VkExtent2D& extent,
+                                          unsigned frameIndex)>;
+
+    Renderer(const VkDeviceWrap& device,
+             SwapchainResources& swapchain,
+             RecordFunc recordFunc,
+             unsigned framesInFlight,
+             QueueTimeline& graphicsTimeline,
+             QueueTimeline& presentTimeline);
+
+    Renderer(const Renderer&) = delete;
+    Renderer& operator=(const Renderer&) = delete;
+
+    ~Renderer();
+
+    void drawFrame();
+
+    // Thread safe, the swapchain is recreated at the beginning of the next frame
+    void notifyResized() { m_resizeRequested = true; }
+    // Rebuilds the swapchain right away, returns false while the window has zero area
+    bool recreateSwapchain();
+
+    const FrameRing& frameRing() const { return m_frameRing; }
+
+private:
+    const VkDeviceWrap& m_device;
+    SwapchainResources& m_swapchain;
+    RecordFunc m_recordFunc;
+    QueueTimeline& m_graphicsTimeline;
+    FrameRing m_frameRing;
+    FrameCommandAllocator m_commandAllocator;
+    QueueTimeline& m_presentTimeline;
+    std::atomic<bool> m_resizeRequested {false};
+    bool m_swapchainValid = true;
+};
+
+// Single color attachment pass cleared to black, the layout every RecordFunc of the app uses
+void beginRenderPass(VkCommandBuffer commandBuffer,
+                     VkRenderPass renderPass,
+                     VkFramebuffer framebuffer,
+                     const VkExtent2D& extent,
+                     VkSubpassContents contents);
@@ -0,0 +1,163 @@
+#include "ShaderLibrary.hpp"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include "CpuTracer.hpp"
+
+namespace {
+
+constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+
+// FNV-1a over 32 bit words, SPIR-V is always word aligned
+uint64_t hashSpirv(const uint32_t* code, size_t wordCount) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < wordCount; ++i) {
+        hash ^= code[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+/// Read only mapping of a whole file, unmapped on destruction.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("Failed to open file " + path);
+        
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) != 0) {
+            close(fd);
+            throw std::runtime_error("Failed to stat file " + path);
+        }
+        m_size = static_cast<size_t>(fileStat.st_size);
+        
+        if (m_size > 0) {
+            m_data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (m_data == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error("Failed to map file " + path);
+            }
+        }
+        // Mapping stays valid after the descriptor is closed
+        close(fd);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        if (m_data != nullptr)
+            munmap(m_data, m_size);
+    }
+
+    const void* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    void* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+bool hasSpirvExtension(const std::string& fileName) {
+    const std::string extension = ".spv";
+    return fileName.size() > extension.size()
+        && fileName.compare(fileName.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+} // namespace
+
+ShaderModule::ShaderModule(VkDevice device, const uint32_t* code, size_t codeSize, uint64_t contentHash)
+    : m_device(device)
+    , m_contentHash(contentHash)
+{
+    VkShaderModuleCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = codeSize;
+    createInfo.pCode = code;
+    if (vkCreateShaderModule(device, &createInfo, nullptr, &m_module) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shader module!");
+    }
+}
+
+ShaderModule::~ShaderModule() {
+    vkDestroyShaderModule(m_device, m_module, nullptr);
+}
+
+ShaderLibrary::ShaderLibrary(VkDevice device)
+    : m_device(device)
+{
+}
+
+void ShaderLibrary::loadDirectory(const std::string& directory) {
+    TRACE_ZONE("ShaderLibrary::loadDirectory");
+    DIR* dir = opendir(directory.c_str());
+    if (dir == nullptr)
+        throw std::runtime_error("Failed to open shader directory " + directory);
+    
+    std::vector<std::string> fileNames;
+    while (dirent* entry = readdir(dir)) {
+        if (hasSpirvExtension(entry->d_name))
+            fileNames.emplace_back(entry->d_name);
+    }
+    closedir(dir);
+    
+    for (const auto& fileName : fileNames)
+        load(directory + "/" + fileName, fileName);
+}
+
+std::shared_ptr<ShaderModule> ShaderLibrary::load(const std::string& path, const std::string& name) {
+    MappedFile file(path);
+    if (file.size() < sizeof(uint32_t) || file.size() % sizeof(uint32_t) != 0)
+        throw std::runtime_error("Invalid SPIR-V size in " + path);
+    // mmap returns page aligned memory, so the code can be read as words in place
+    const auto* code = static_cast<const uint32_t*>(file.data());
+    if (code[0] != SPIRV_MAGIC)
+        throw std::runtime_error("Invalid SPIR-V magic in " + path);
+    
+    uint64_t contentHash = hashSpirv(code, file.size() / sizeof(uint32_t));
+    
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto moduleIt = m_modules.find(contentHash);
+    if (moduleIt == m_modules.end()) {
+        // Registered only once the driver accepted the code, a failed load leaves no entry behind
+        auto module = std::make_shared<ShaderModule>(m_device, code, file.size(), contentHash);
+        moduleIt = m_modules.emplace(contentHash, std::move(module)).first;
+    }
+    m_names[name] = contentHash;
+    return moduleIt->second;
+}
+
+std::shared_ptr<ShaderModule> ShaderLibrary::get(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto nameIt = m_names.find(name);
+    if (nameIt != m_names.end()) {
+        auto moduleIt = m_modules.find(nameIt->second);
+        if (moduleIt != m_modules.end())
+            return moduleIt->second;
+    }
+    throw std::runtime_error("Shader " + name + " is not loaded");
+}
+
+void ShaderLibrary::trim() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_modules.begin(); it != m_modules.end();) {
+        if (it->second.use_count() == 1)
+            it = m_modules.erase(it);
+        else
+            ++it;
+    }
+}
+
+size_t ShaderLibrary::moduleCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_modules.size();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+class ShaderModule {
+public:
+    ShaderModule(VkDevice device, const uint32_t* code, size_t codeSize, uint64_t contentHash);
+
+    ShaderModule(const ShaderModule&) = delete;
+    ShaderModule& operator=(const ShaderModule&) = delete;
+
+    ~ShaderModule();
+
+    VkShaderModule module() const { return m_module; }
+    uint64_t contentHash() const { return m_contentHash; }
+
+private:
+    VkDevice m_device;
+    VkShaderModule m_module;
+    uint64_t m_contentHash;
+};
+
+/// SPIR-V files are memory mapped and handed to the driver without intermediate copies.
+/// Modules are deduplicated by content hash, so identical code loaded under different names
+/// shares one VkShaderModule. Code isn't compared on a hash match, so the unlikely collision of
+/// two different files in the 64 bit FNV-1a hash would silently load the first module for both.
+/// Users hold shared_ptr references; trim() drops unused modules.
+class ShaderLibrary {
+public:
+    explicit ShaderLibrary(VkDevice device);
+
+    ShaderLibrary(const ShaderLibrary&) = delete;
+    ShaderLibrary& operator=(const ShaderLibrary&) = delete;
+
+    // Loads every *.spv file of the directory, modules are registered under file names
+    void loadDirectory(const std::string& directory);
+    std::shared_ptr<ShaderModule> load(const std::string& path, const std::string& name);
+    // Throws when nothing was loaded under the name
+    std::shared_ptr<ShaderModule> get(const std::string& name) const;
+
+    // Destroys modules nobody but the library references
+    void trim();
+
+    size_t moduleCount() const;
+
+private:
+    VkDevice m_device;
+    mutable std::mutex m_mutex;
+    std::unordered_map<uint64_t, std::shared_ptr<ShaderModule>> m_modules; // By content hash
+    std::unordered_map<std::string, uint64_t> m_names;
+};
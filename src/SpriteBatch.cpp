@@ -0,0 +1,108 @@
+#include "SpriteBatch.hpp"
+
+#include <cstddef>
+#include <stdexcept>
+
+#include "VkDeviceWrap.hpp"
+#include "VkBufferWrap.hpp"
+#include "PipelineRegistry.hpp"
+
+namespace {
+
+// Triangle strip of the unit quad centered at the origin
+const Vec2 QUAD_CORNERS[] = {{-0.5f, -0.5f}, {0.5f, -0.5f}, {-0.5f, 0.5f}, {0.5f, 0.5f}};
+
+} // namespace
+
+SpriteBatch::SpriteBatch(const VkDeviceWrap& device, UploadQueue& uploadQueue, StreamingRingBuffer& stream)
+    : m_stream(stream)
+{
+    m_cornerBuffer = std::make_shared<VkBufferWrap>(device,
+                                                    sizeof(QUAD_CORNERS),
+                                                    VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    uploadQueue.uploadBuffer(QUAD_CORNERS, sizeof(QUAD_CORNERS), m_cornerBuffer->buffer());
+    m_uploadTicket = uploadQueue.flush();
+}
+
+void SpriteBatch::fillPipelineDesc(PipelineDesc& desc) const {
+    VkVertexInputBindingDescription cornerBinding = {};
+    cornerBinding.binding = 0;
+    cornerBinding.stride = sizeof(Vec2);
+    cornerBinding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    
+    VkVertexInputBindingDescription instanceBinding = {};
+    instanceBinding.binding = 1;
+    instanceBinding.stride = sizeof(SpriteInstance);
+    instanceBinding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+    
+    desc.vertexBindings = {cornerBinding, instanceBinding};
+    desc.vertexAttributes = {
+        {0, 0, VK_FORMAT_R32G32_SFLOAT, 0},
+        {1, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(SpriteInstance, transform)},
+        {2, 1, VK_FORMAT_R32G32_SFLOAT, offsetof(SpriteInstance, position)},
+        {3, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(SpriteInstance, color)},
+        {4, 1, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(SpriteInstance, uvRect)},
+    };
+    desc.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+    // Mirrored sprites have a negative determinant
+    desc.cullMode = VK_CULL_MODE_NONE;
+}
+
+void SpriteBatch::begin() {
+    m_spriteCount = 0;
+    m_droppedCount = 0;
+    m_batches.clear();
+}
+
+SpriteInstance* SpriteBatch::allocate(VkPipeline pipeline, size_t count) {
+    auto allocation = m_stream.allocate(sizeof(SpriteInstance) * count, alignof(SpriteInstance));
+    if (!allocation) {
+        m_droppedCount += count;
+        return nullptr;
+    }
+    // Consecutive allocations usually follow each other in the ring and extend the same draw
+    if (m_batches.empty()
+        || m_batches.back().pipeline != pipeline
+        || m_batches.back().instanceOffset + sizeof(SpriteInstance) * m_batches.back().instanceCount != allocation.offset)
+        m_batches.push_back({pipeline, allocation.offset, 0});
+    m_batches.back().instanceCount += static_cast<uint32_t>(count);
+    m_spriteCount += count;
+    return static_cast<SpriteInstance*>(allocation.data);
+}
+
+void SpriteBatch::add(VkPipeline pipeline, const SpriteInstance& sprite) {
+    if (SpriteInstance* instance = allocate(pipeline, 1))
+        *instance = sprite;
+}
+
+void SpriteBatch::record(VkCommandBuffer commandBuffer, const VkExtent2D& extent) const {
+    if (m_batches.empty())
+        return;
+    
+    VkViewport viewport = {};
+    viewport.width = (float) extent.width;
+    viewport.height = (float) extent.height;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    
+    VkRect2D scissor = {};
+    scissor.extent = extent;
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    
+    VkBuffer cornerBuffer = m_cornerBuffer->buffer();
+    VkDeviceSize cornerOffset = 0;
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &cornerBuffer, &cornerOffset);
+    
+    // Batches start wherever the ring placed them, the instance binding points at each one
+    VkBuffer instanceBuffer = m_stream.buffer();
+    VkPipeline boundPipeline = VK_NULL_HANDLE;
+    for (const auto& batch : m_batches) {
+        if (batch.pipeline != boundPipeline) {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, batch.pipeline);
+            boundPipeline = batch.pipeline;
+        }
+        vkCmdBindVertexBuffers(commandBuffer, 1, 1, &instanceBuffer, &batch.instanceOffset);
+        vkCmdDraw(commandBuffer, 4, batch.instanceCount, 0, 0);
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <vector>
+
+#include "QuadScene.hpp"
+#include "UploadQueue.hpp"
+#include "StreamingRingBuffer.hpp"
+
+class VkDeviceWrap;
+class VkBufferWrap;
+struct PipelineDesc;
+
+// Per-instance vertex data of one sprite, the vertex shader places a unit quad with it
+struct SpriteInstance {
+    Vec4 transform; // Columns of a 2x2 matrix (xy, zw), rotation and size in clip space
+    Vec2 position;  // Center in clip space
+    Vec4 color;
+    Vec4 uvRect;    // Offset in xy, size in zw
+};
+
+/// Draws many sprites with one instanced draw per batch. Instances of a frame are written straight into
+/// a StreamingRingBuffer, so nothing is copied or uploaded and memory is reused once the frame retires.
+/// A batch is a run of sprites sharing a pipeline, it ends when the pipeline changes.
+class SpriteBatch {
+public:
+    // stream needs VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, its frames are begun and ended by the caller
+    SpriteBatch(const VkDeviceWrap& device, UploadQueue& uploadQueue, StreamingRingBuffer& stream);
+
+    // Vertex layout and topology of sprite pipelines, shaders are sprite_vert.spv and sprite_frag.spv
+    void fillPipelineDesc(PipelineDesc& desc) const;
+
+    // Forgets the batches of the previous frame, called after StreamingRingBuffer::beginFrame()
+    void begin();
+    // Returns space for count sprites drawn with pipeline, written in place. Null when the ring is full,
+    // the sprites are counted as dropped then.
+    SpriteInstance* allocate(VkPipeline pipeline, size_t count);
+    void add(VkPipeline pipeline, const SpriteInstance& sprite);
+    // Sets viewport and scissor, then records one instanced draw per batch of the frame
+    void record(VkCommandBuffer commandBuffer, const VkExtent2D& extent) const;
+
+    size_t spriteCount() const { return m_spriteCount; }
+    size_t batchCount() const { return m_batches.size(); }
+    size_t droppedCount() const { return m_droppedCount; }
+    // The corner buffer must not be drawn before the upload is complete
+    UploadTicket uploadTicket() const { return m_uploadTicket; }
+
+private:
+    struct Batch {
+        VkPipeline pipeline;
+        VkDeviceSize instanceOffset;
+        uint32_t instanceCount;
+    };
+
+    StreamingRingBuffer& m_stream;
+    std::shared_ptr<VkBufferWrap> m_cornerBuffer;
+    size_t m_spriteCount = 0;
+    size_t m_droppedCount = 0;
+    std::vector<Batch> m_batches; // Capacity is kept between frames
+    UploadTicket m_uploadTicket;
+};
@@ -0,0 +1,55 @@
+#include "SpriteScene.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+#include "VertexKernels.hpp"
+
+SpriteScene::SpriteScene(size_t spriteCount) {
+    if (spriteCount == 0)
+        throw std::runtime_error("Scene needs at least one sprite");
+    
+    // Same square grid as QuadScene, neighbours spin out of phase
+    const auto gridSize = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(spriteCount))));
+    const float cellSize = 2.0f / gridSize;
+    m_sprites.reserve(spriteCount);
+    m_gridPositions.reserve(spriteCount);
+    for (size_t i = 0; i < spriteCount; ++i) {
+        const size_t column = i % gridSize;
+        const size_t row = i / gridSize;
+        m_gridPositions.push_back({-1.0f + cellSize * (column + 0.5f), -1.0f + cellSize * (row + 0.5f)});
+        Sprite sprite;
+        sprite.size = cellSize * 0.6f;
+        sprite.phase = 0.37f * i;
+        sprite.color = {float(column) / gridSize, float(row) / gridSize, 1.0f - float(column) / gridSize, 1.0f};
+        m_sprites.push_back(sprite);
+    }
+    m_positions.resize(spriteCount);
+}
+
+void SpriteScene::update(SpriteBatch& batch, VkPipeline pipeline, float time) {
+    SpriteInstance* instances = batch.allocate(pipeline, m_sprites.size());
+    if (instances == nullptr)
+        return;
+    
+    // Slight rotation and shrink keep every sprite on screen
+    const float swayAngle = 0.05f * std::sin(time * 0.5f);
+    const float swayScale = 0.95f;
+    const float swayCos = std::cos(swayAngle) * swayScale;
+    const float swaySin = std::sin(swayAngle) * swayScale;
+    const Affine2D sway {swayCos, swaySin, -swaySin, swayCos, 0.0f, 0.0f};
+    vertexKernels().transformPoints(sway, m_gridPositions.data(), m_positions.data(), m_positions.size());
+    
+    for (size_t i = 0; i < m_sprites.size(); ++i) {
+        const auto& sprite = m_sprites[i];
+        const float angle = sprite.phase + time;
+        const float scale = sprite.size * (0.75f + 0.25f * std::sin(angle * 2.0f));
+        const float c = std::cos(angle) * scale;
+        const float s = std::sin(angle) * scale;
+        instances->transform = {c, s, -s, c};
+        instances->position = m_positions[i];
+        instances->color = sprite.color;
+        instances->uvRect = {0.0f, 0.0f, 1.0f, 1.0f};
+        ++instances;
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+#include "SpriteBatch.hpp"
+
+/// Grid of sprites spinning and pulsing in place while the whole grid sways, rebuilt into a SpriteBatch
+/// every frame like a game would stream its moving objects. Positions go through the SIMD vertex kernels.
+class SpriteScene {
+public:
+    explicit SpriteScene(size_t spriteCount);
+
+    // Writes every sprite at time (seconds) into the current frame of batch as one batch
+    void update(SpriteBatch& batch, VkPipeline pipeline, float time);
+
+    size_t spriteCount() const { return m_sprites.size(); }
+
+private:
+    struct Sprite {
+        float size;
+        float phase;
+        Vec4 color;
+    };
+
+    std::vector<Sprite> m_sprites;
+    // Kept apart from the sprites, so the kernels transform them as one packed array
+    std::vector<Vec2> m_gridPositions;
+    std::vector<Vec2> m_positions; // Positions of the current frame
+};
@@ -0,0 +1,107 @@
+#include "StreamingRingBuffer.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "VkDeviceWrap.hpp"
+#include "VkBufferWrap.hpp"
+
+namespace {
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+VkDeviceSize alignDown(VkDeviceSize value, VkDeviceSize alignment) {
+    return value / alignment * alignment;
+}
+
+} // namespace
+
+StreamingRingBuffer::StreamingRingBuffer(const VkDeviceWrap& device,
+                                         VkDeviceSize capacity,
+                                         VkBufferUsageFlags usage,
+                                         unsigned framesInFlight)
+    : m_device(device)
+    , m_frameEnds(framesInFlight, 0)
+{
+    if (framesInFlight == 0 || capacity == 0)
+        throw std::runtime_error("Streaming ring needs at least one frame and one byte");
+    
+    const auto& capabilities = device.physicalDevice().capabilities();
+    const auto& limits = capabilities.limits();
+    m_uniformAlignment = std::max<VkDeviceSize>(limits.minUniformBufferOffsetAlignment, 1);
+    m_atomSize = std::max<VkDeviceSize>(limits.nonCoherentAtomSize, 1);
+    
+    // Any alignment up to MAX_ALIGNMENT divides the capacity, so aligned positions stay aligned after the wrap,
+    // and flushed ranges rounded to atoms never leave the buffer
+    m_capacity = alignUp(capacity, MAX_ALIGNMENT);
+    m_bufferWrap = std::make_shared<VkBufferWrap>(device,
+                                                  static_cast<int>(m_capacity),
+                                                  usage,
+                                                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+                                                  m_atomSize);
+    m_buffer = m_bufferWrap->buffer();
+    m_mappedData = static_cast<char*>(m_bufferWrap->mappedData());
+    m_memoryOffset = m_bufferWrap->memoryOffset();
+    if (m_mappedData == nullptr)
+        throw std::runtime_error("Streaming ring buffer isn't mapped");
+    
+    const auto propertyFlags = capabilities.memoryTypeFlags(m_bufferWrap->memoryTypeIndex());
+    m_coherent = (propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+}
+
+StreamingRingBuffer::~StreamingRingBuffer() {
+}
+
+void StreamingRingBuffer::beginFrame(unsigned frameIndex) {
+    // Frames retire in submission order, everything up to the end of this slot's previous frame is free
+    m_tail = std::max(m_tail, m_frameEnds[frameIndex]);
+    m_frameIndex = frameIndex;
+    m_frameBegin = m_head;
+}
+
+StreamAllocation StreamingRingBuffer::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+    if (alignment == 0 || alignment > MAX_ALIGNMENT || (alignment & (alignment - 1)) != 0)
+        throw std::runtime_error("Streaming ring alignment must be a power of two up to 256");
+    
+    VkDeviceSize begin = alignUp(m_head, alignment);
+    // Allocations never straddle the end of the buffer, the rest of the lap is skipped instead
+    if (begin % m_capacity + size > m_capacity)
+        begin = alignUp(begin, m_capacity);
+    if (size > m_capacity || begin + size - m_tail > m_capacity) {
+        ++m_failedCount;
+        return {};
+    }
+    m_head = begin + size;
+    
+    StreamAllocation allocation;
+    allocation.buffer = m_buffer;
+    allocation.offset = begin % m_capacity;
+    allocation.size = size;
+    allocation.data = m_mappedData + allocation.offset;
+    return allocation;
+}
+
+void StreamingRingBuffer::endFrame() {
+    m_frameEnds[m_frameIndex] = m_head;
+    if (m_coherent || m_head == m_frameBegin)
+        return;
+    
+    // The frame occupies [m_frameBegin, m_head), split in two where it wraps around
+    VkMappedMemoryRange ranges[2] = {};
+    uint32_t rangeCount = 0;
+    VkDeviceSize position = m_frameBegin;
+    while (position < m_head) {
+        const VkDeviceSize lapEnd = std::min(alignDown(position, m_capacity) + m_capacity, m_head);
+        const VkDeviceSize begin = alignDown(position % m_capacity, m_atomSize);
+        const VkDeviceSize end = std::min(alignUp(lapEnd - alignDown(position, m_capacity), m_atomSize), m_capacity);
+        auto& range = ranges[rangeCount++];
+        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        range.memory = m_bufferWrap->deviceMemory();
+        range.offset = m_memoryOffset + begin;
+        range.size = end - begin;
+        position = lapEnd;
+    }
+    vkFlushMappedMemoryRanges(m_device.device(), rangeCount, ranges);
+}
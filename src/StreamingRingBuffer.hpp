@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <vector>
+
+class VkDeviceWrap;
+class VkBufferWrap;
+
+struct StreamAllocation {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    void* data = nullptr; // Null when the ring was full
+
+    explicit operator bool() const { return data != nullptr; }
+};
+
+/// Persistently mapped ring for data written by the CPU every frame (dynamic vertices, instances, uniforms).
+/// Allocations are bump-allocated from the head, the space of a frame is reclaimed when its FrameRing slot
+/// comes around again, which means its fence has signaled. Frames may use different amounts, only their sum
+/// over the frames in flight is bounded by the capacity. Non-coherent memory is flushed once per frame.
+class StreamingRingBuffer {
+public:
+    static constexpr VkDeviceSize MAX_ALIGNMENT = 256; // Upper bound of every alignment limit in the spec
+
+    StreamingRingBuffer(const VkDeviceWrap& device, VkDeviceSize capacity, VkBufferUsageFlags usage, unsigned framesInFlight);
+
+    StreamingRingBuffer(const StreamingRingBuffer&) = delete;
+    StreamingRingBuffer& operator=(const StreamingRingBuffer&) = delete;
+
+    ~StreamingRingBuffer();
+
+    // Reclaims what the frame previously recorded in frameIndex allocated, FrameRing::beginFrame() has to have returned it
+    void beginFrame(unsigned frameIndex);
+    // alignment is a power of two up to MAX_ALIGNMENT. A failed allocation is counted and returns an empty result.
+    StreamAllocation allocate(VkDeviceSize size, VkDeviceSize alignment = 16);
+    // Aligned to minUniformBufferOffsetAlignment
+    StreamAllocation allocateUniform(VkDeviceSize size) { return allocate(size, m_uniformAlignment); }
+    // Makes everything written since beginFrame visible to the device, call before the frame is submitted.
+    // Non-coherent memory is flushed with a single vkFlushMappedMemoryRanges of at most two ranges.
+    void endFrame();
+
+    VkBuffer buffer() const { return m_buffer; }
+    VkDeviceSize capacity() const { return m_capacity; }
+    bool isCoherent() const { return m_coherent; }
+    // Bytes the CPU may not overwrite yet, including padding and frames still in flight
+    VkDeviceSize usedBytes() const { return m_head - m_tail; }
+    VkDeviceSize frameBytes() const { return m_head - m_frameBegin; }
+    size_t failedCount() const { return m_failedCount; }
+
+private:
+    const VkDeviceWrap& m_device;
+    std::shared_ptr<VkBufferWrap> m_bufferWrap;
+    VkBuffer m_buffer;
+    char* m_mappedData;
+    VkDeviceSize m_capacity;
+    VkDeviceSize m_memoryOffset;
+    VkDeviceSize m_uniformAlignment;
+    VkDeviceSize m_atomSize;
+    bool m_coherent;
+    
+    // Positions grow monotonically, the buffer offset is position % capacity
+    VkDeviceSize m_head = 0;
+    VkDeviceSize m_tail = 0;
+    VkDeviceSize m_frameBegin = 0;
+    std::vector<VkDeviceSize> m_frameEnds; // Head at endFrame of the frame last recorded in each slot
+    unsigned m_frameIndex = 0;
+    size_t m_failedCount = 0;
+};
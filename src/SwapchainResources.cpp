@@ -0,0 +1,133 @@
+#include "SwapchainResources.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "VkDeviceWrap.hpp"
+#include "VkSurfaceWrap.hpp"
+#include "CpuTracer.hpp"
+
+namespace {
+
+VkImageView createImageView(VkDevice device, VkImage image, VkFormat format) {
+    VkImageViewCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    createInfo.image = image;
+    createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    createInfo.format = format;
+    createInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+    createInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+    createInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+    createInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+    createInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    createInfo.subresourceRange.baseMipLevel = 0;
+    createInfo.subresourceRange.levelCount = 1;
+    createInfo.subresourceRange.baseArrayLayer = 0;
+    createInfo.subresourceRange.layerCount = 1;
+    
+    VkImageView imageView;
+    if (vkCreateImageView(device, &createInfo, nullptr, &imageView) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create image views!");
+    }
+    return imageView;
+}
+
+VkFramebuffer createFramebuffer(VkDevice device, VkRenderPass renderPass, VkImageView imageView, const VkExtent2D& extent) {
+    VkImageView attachments[] = { imageView };
+    
+    VkFramebufferCreateInfo framebufferInfo = {};
+    framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferInfo.renderPass = renderPass;
+    framebufferInfo.attachmentCount = 1;
+    framebufferInfo.pAttachments = attachments;
+    framebufferInfo.width = extent.width;
+    framebufferInfo.height = extent.height;
+    framebufferInfo.layers = 1;
+    
+    VkFramebuffer framebuffer;
+    if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create framebuffer!");
+    }
+    return framebuffer;
+}
+
+} // namespace
+
+SwapchainResources::SwapchainResources(const VkDeviceWrap& device,
+                                       const VkSurfaceWrap& surface,
+                                       VkRenderPass renderPass,
+                                       const SwapchainSettings& settings)
+    : m_device(device)
+    , m_surface(surface)
+    , m_renderPass(renderPass)
+    , m_settings(settings)
+    , m_preferredExtent(settings.extent)
+    , m_swapchain(std::make_unique<VkSwapchainWrap>(device, surface, settings))
+{
+    createImageResources();
+}
+
+SwapchainResources::~SwapchainResources() {
+    destroyImageResources();
+}
+
+bool SwapchainResources::recreate() {
+    TRACE_ZONE("SwapchainResources::recreate");
+    VkSurfaceCapabilitiesKHR capabilities;
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_device.physicalDevice().physicalDevice(), m_surface.surface(), &capabilities);
+    
+    VkExtent2D extent = capabilities.currentExtent;
+    if (extent.width == std::numeric_limits<uint32_t>::max()) {
+        // Surface size is defined by the swapchain
+        std::lock_guard<std::mutex> lock(m_preferredExtentMutex);
+        extent.width = std::clamp(m_preferredExtent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
+        extent.height = std::clamp(m_preferredExtent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
+    }
+    if (extent.width == 0 || extent.height == 0)
+        return false;
+    
+    m_settings.extent = extent;
+    m_settings.transform = capabilities.currentTransform;
+    
+    // New swapchain is created before the old one is destroyed, so presentation never runs dry
+    auto newSwapchain = std::make_unique<VkSwapchainWrap>(m_device, m_surface, m_settings, m_swapchain->swapchain());
+    releaseImageResources();
+    // Retired along with its framebuffers, once the frames presenting from it are done
+    VkSwapchainWrap* oldSwapchain = m_swapchain.release();
+    m_device.deletionQueue().release([oldSwapchain]() { delete oldSwapchain; });
+    m_swapchain = std::move(newSwapchain);
+    createImageResources();
+    return true;
+}
+
+void SwapchainResources::setPreferredExtent(const VkExtent2D& extent) {
+    std::lock_guard<std::mutex> lock(m_preferredExtentMutex);
+    m_preferredExtent = extent;
+}
+
+void SwapchainResources::createImageResources() {
+    for (auto image : m_swapchain->getSwapchainImages()) {
+        m_imageViews.push_back(createImageView(m_device.device(), image, m_settings.surfaceFormat.format));
+        m_framebuffers.push_back(createFramebuffer(m_device.device(), m_renderPass, m_imageViews.back(), m_settings.extent));
+    }
+}
+
+void SwapchainResources::releaseImageResources() {
+    auto& deletionQueue = m_device.deletionQueue();
+    for (auto framebuffer : m_framebuffers)
+        deletionQueue.destroyFramebuffer(framebuffer);
+    m_framebuffers.clear();
+    for (auto imageView : m_imageViews)
+        deletionQueue.destroyImageView(imageView);
+    m_imageViews.clear();
+}
+
+void SwapchainResources::destroyImageResources() {
+    for (auto framebuffer : m_framebuffers)
+        vkDestroyFramebuffer(m_device.device(), framebuffer, nullptr);
+    m_framebuffers.clear();
+    for (auto imageView : m_imageViews)
+        vkDestroyImageView(m_device.device(), imageView, nullptr);
+    m_imageViews.clear();
+}
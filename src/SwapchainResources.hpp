@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "VkSwapchainWrap.hpp"
+
+class VkDeviceWrap;
+class VkSurfaceWrap;
+
+/// Swapchain with everything that depends on its images. Recreation on resize rebuilds only these,
+/// render passes and pipelines stay valid because viewport and scissor are dynamic.
+class SwapchainResources {
+public:
+    SwapchainResources(const VkDeviceWrap& device,
+                       const VkSurfaceWrap& surface,
+                       VkRenderPass renderPass,
+                       const SwapchainSettings& settings);
+
+    SwapchainResources(const SwapchainResources&) = delete;
+    SwapchainResources& operator=(const SwapchainResources&) = delete;
+
+    ~SwapchainResources();
+
+    // Frames in flight may still use the old swapchain, it goes through the deletion queue with its framebuffers.
+    // Returns false when the surface has zero area (minimized window), old resources stay in place then.
+    bool recreate();
+    // Used when the surface leaves the size to the swapchain (headless surfaces), thread safe
+    void setPreferredExtent(const VkExtent2D& extent);
+
+    VkSwapchainKHR swapchain() const { return m_swapchain->swapchain(); }
+    const VkExtent2D& extent() const { return m_settings.extent; }
+    VkFormat format() const { return m_settings.surfaceFormat.format; }
+    uint32_t imageCount() const { return static_cast<uint32_t>(m_framebuffers.size()); }
+    VkFramebuffer framebuffer(uint32_t imageIndex) const { return m_framebuffers[imageIndex]; }
+
+private:
+    const VkDeviceWrap& m_device;
+    const VkSurfaceWrap& m_surface;
+    VkRenderPass m_renderPass;
+    SwapchainSettings m_settings;
+    VkExtent2D m_preferredExtent;
+    std::mutex m_preferredExtentMutex;
+    std::unique_ptr<VkSwapchainWrap> m_swapchain;
+    std::vector<VkImageView> m_imageViews;
+    std::vector<VkFramebuffer> m_framebuffers;
+
+    void createImageResources();
+    // Deferred until the frames using them retire
+    void releaseImageResources();
+    void destroyImageResources();
+};
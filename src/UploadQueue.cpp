@@ -0,0 +1,351 @@
+#include "UploadQueue.hpp"
+
+#include <stdexcept>
+
+#include "VkDeviceWrap.hpp"
+#include "VkBufferWrap.hpp"
+#include "HostBufferController.hpp"
+#include "QueueTimeline.hpp"
+#include "CpuTracer.hpp"
+
+namespace {
+
+const VkAccessFlags UPLOAD_CONSUMER_ACCESS = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT
+                                             | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+const VkPipelineStageFlags UPLOAD_CONSUMER_STAGES = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT
+                                                    | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+VkCommandPool createUploadCommandPool(VkDevice device, uint32_t queueFamilyIndex) {
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = queueFamilyIndex;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    VkCommandPool commandPool;
+    if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+        throw std::runtime_error("failed to create upload command pool!");
+    return commandPool;
+}
+
+VkCommandBuffer allocateCommandBuffer(VkDevice device, VkCommandPool commandPool) {
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = commandPool;
+    allocInfo.commandBufferCount = 1;
+    VkCommandBuffer commandBuffer;
+    if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+        throw std::runtime_error("Failed to allocate upload command buffer!");
+    return commandBuffer;
+}
+
+void beginCommandBuffer(VkCommandBuffer commandBuffer) {
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+        throw std::runtime_error("failed to begin recording upload command buffer!");
+}
+
+} // namespace
+
+UploadQueue::UploadQueue(const VkDeviceWrap& device,
+                         uint32_t transferFamily, QueueTimeline& transferTimeline,
+                         uint32_t graphicsFamily, QueueTimeline& graphicsTimeline)
+    : m_device(device)
+    , m_transferFamily(transferFamily)
+    , m_transferTimeline(transferTimeline)
+    , m_graphicsFamily(graphicsFamily)
+    , m_graphicsTimeline(graphicsTimeline)
+    , m_completionTimeline(transferFamily != graphicsFamily ? graphicsTimeline : transferTimeline)
+{
+    m_commandPool = createUploadCommandPool(device.device(), transferFamily);
+    if (transfersOwnership())
+        m_acquireCommandPool = createUploadCommandPool(device.device(), graphicsFamily);
+    
+    m_recording.ticket = 1;
+}
+
+UploadQueue::~UploadQueue() {
+    waitIdle();
+    
+    auto destroyBatch = [this](Batch& batch) {
+        if (batch.transferSemaphore != VK_NULL_HANDLE)
+            vkDestroySemaphore(m_device.device(), batch.transferSemaphore, nullptr);
+    };
+    destroyBatch(m_recording);
+    for (auto& batch : m_freeBatches)
+        destroyBatch(batch);
+    // Command buffers are freed along with the pools
+    if (m_acquireCommandPool != VK_NULL_HANDLE)
+        vkDestroyCommandPool(m_device.device(), m_acquireCommandPool, nullptr);
+    vkDestroyCommandPool(m_device.device(), m_commandPool, nullptr);
+}
+
+UploadTicket UploadQueue::uploadBuffer(const void* data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset) {
+    TRACE_ZONE("UploadQueue::uploadBuffer");
+    auto stagingBuffer = createStagingBuffer(data, size);
+    
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& batch = recordingBatch();
+    
+    VkBufferCopy copyRegion = {};
+    copyRegion.srcOffset = 0;
+    copyRegion.dstOffset = dstOffset;
+    copyRegion.size = size;
+    vkCmdCopyBuffer(batch.commandBuffer, stagingBuffer->buffer(), dstBuffer, 1, &copyRegion);
+    releaseBuffer(batch, dstBuffer, dstOffset, size);
+    
+    batch.stagingBuffers.push_back(std::move(stagingBuffer));
+    ++batch.copyCount;
+    return batch.ticket;
+}
+
+UploadTicket UploadQueue::uploadImage(const void* data,
+                                      VkDeviceSize size,
+                                      VkImage dstImage,
+                                      const VkExtent3D& extent,
+                                      VkImageLayout finalLayout)
+{
+    auto stagingBuffer = createStagingBuffer(data, size);
+    
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& batch = recordingBatch();
+    
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = dstImage;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(batch.commandBuffer,
+                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                         0, nullptr, 0, nullptr, 1, &barrier);
+    
+    VkBufferImageCopy region = {};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = extent;
+    vkCmdCopyBufferToImage(batch.commandBuffer, stagingBuffer->buffer(), dstImage,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = finalLayout;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    if (transfersOwnership()) {
+        // Release half, the layout transition must match on both sides
+        barrier.srcQueueFamilyIndex = m_transferFamily;
+        barrier.dstQueueFamilyIndex = m_graphicsFamily;
+        barrier.dstAccessMask = 0;
+        vkCmdPipelineBarrier(batch.commandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                             0, nullptr, 0, nullptr, 1, &barrier);
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        batch.acquireImageBarriers.push_back(barrier);
+    } else {
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(batch.commandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                             0, nullptr, 0, nullptr, 1, &barrier);
+    }
+    
+    batch.stagingBuffers.push_back(std::move(stagingBuffer));
+    ++batch.copyCount;
+    return batch.ticket;
+}
+
+UploadTicket UploadQueue::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& batch = recordingBatch();
+    
+    VkBufferCopy copyRegion = {};
+    copyRegion.srcOffset = 0;
+    copyRegion.dstOffset = 0;
+    copyRegion.size = size;
+    vkCmdCopyBuffer(batch.commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+    releaseBuffer(batch, dstBuffer, 0, size);
+    
+    ++batch.copyCount;
+    return batch.ticket;
+}
+
+UploadTicket UploadQueue::flush() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return flushRecording();
+}
+
+UploadTicket UploadQueue::flushRecording() {
+    TRACE_ZONE("UploadQueue::flush");
+    if (m_recording.copyCount == 0)
+        return m_recording.ticket - 1;
+    
+    if (!transfersOwnership()) {
+        // Make transfer writes visible to every later use of the uploaded data on this queue
+        VkMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = UPLOAD_CONSUMER_ACCESS;
+        vkCmdPipelineBarrier(m_recording.commandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, UPLOAD_CONSUMER_STAGES,
+                             0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+    
+    if (vkEndCommandBuffer(m_recording.commandBuffer) != VK_SUCCESS)
+        throw std::runtime_error("failed to record upload command buffer!");
+    
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &m_recording.commandBuffer;
+    
+    if (!transfersOwnership()) {
+        m_recording.timelineValue = m_transferTimeline.submit(submitInfo);
+    } else {
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &m_recording.transferSemaphore;
+        m_transferTimeline.submit(submitInfo);
+        
+        auto acquireCommandBuffer = m_recording.acquireCommandBuffer;
+        beginCommandBuffer(acquireCommandBuffer);
+        vkCmdPipelineBarrier(acquireCommandBuffer,
+                             VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, UPLOAD_CONSUMER_STAGES, 0,
+                             0, nullptr,
+                             static_cast<uint32_t>(m_recording.acquireBufferBarriers.size()),
+                             m_recording.acquireBufferBarriers.data(),
+                             static_cast<uint32_t>(m_recording.acquireImageBarriers.size()),
+                             m_recording.acquireImageBarriers.data());
+        if (vkEndCommandBuffer(acquireCommandBuffer) != VK_SUCCESS)
+            throw std::runtime_error("failed to record upload command buffer!");
+        
+        VkPipelineStageFlags waitStage = UPLOAD_CONSUMER_STAGES;
+        VkSubmitInfo acquireInfo = {};
+        acquireInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        acquireInfo.waitSemaphoreCount = 1;
+        acquireInfo.pWaitSemaphores = &m_recording.transferSemaphore;
+        acquireInfo.pWaitDstStageMask = &waitStage;
+        acquireInfo.commandBufferCount = 1;
+        acquireInfo.pCommandBuffers = &acquireCommandBuffer;
+        // Acquire retires last, so its value covers the whole batch
+        m_recording.timelineValue = m_graphicsTimeline.submit(acquireInfo);
+    }
+    
+    UploadTicket submittedTicket = m_recording.ticket;
+    m_submitted.push_back(std::move(m_recording));
+    m_recording = Batch();
+    m_recording.ticket = submittedTicket + 1;
+    return submittedTicket;
+}
+
+bool UploadQueue::isComplete(UploadTicket ticket) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    retireCompleted(false, ticket);
+    return ticket <= m_completedTicket;
+}
+
+void UploadQueue::wait(UploadTicket ticket) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Waiting on a batch which is still recording would never finish
+    if (ticket >= m_recording.ticket)
+        flushRecording();
+    retireCompleted(true, ticket);
+}
+
+void UploadQueue::waitIdle() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    retireCompleted(true, flushRecording());
+}
+
+UploadQueue::Batch& UploadQueue::recordingBatch() {
+    if (m_recording.commandBuffer != VK_NULL_HANDLE)
+        return m_recording;
+    
+    // Reuse command buffers and semaphore of a retired batch when possible
+    if (!m_freeBatches.empty()) {
+        auto& freeBatch = m_freeBatches.back();
+        m_recording.commandBuffer = freeBatch.commandBuffer;
+        m_recording.acquireCommandBuffer = freeBatch.acquireCommandBuffer;
+        m_recording.transferSemaphore = freeBatch.transferSemaphore;
+        m_freeBatches.pop_back();
+        vkResetCommandBuffer(m_recording.commandBuffer, 0);
+        if (m_recording.acquireCommandBuffer != VK_NULL_HANDLE)
+            vkResetCommandBuffer(m_recording.acquireCommandBuffer, 0);
+    } else {
+        m_recording.commandBuffer = allocateCommandBuffer(m_device.device(), m_commandPool);
+        
+        if (transfersOwnership()) {
+            m_recording.acquireCommandBuffer = allocateCommandBuffer(m_device.device(), m_acquireCommandPool);
+            VkSemaphoreCreateInfo semaphoreInfo = {};
+            semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            if (vkCreateSemaphore(m_device.device(), &semaphoreInfo, nullptr, &m_recording.transferSemaphore) != VK_SUCCESS)
+                throw std::runtime_error("failed to create semaphore!");
+        }
+    }
+    
+    beginCommandBuffer(m_recording.commandBuffer);
+    return m_recording;
+}
+
+void UploadQueue::releaseBuffer(Batch& batch, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size) {
+    if (!transfersOwnership())
+        return;
+    
+    VkBufferMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+    barrier.srcQueueFamilyIndex = m_transferFamily;
+    barrier.dstQueueFamilyIndex = m_graphicsFamily;
+    barrier.buffer = buffer;
+    barrier.offset = offset;
+    barrier.size = size;
+    vkCmdPipelineBarrier(batch.commandBuffer,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                         0, nullptr, 1, &barrier, 0, nullptr);
+    
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = UPLOAD_CONSUMER_ACCESS;
+    batch.acquireBufferBarriers.push_back(barrier);
+}
+
+std::shared_ptr<VkBufferWrap> UploadQueue::createStagingBuffer(const void* data, VkDeviceSize size) {
+    // Staging buffers are sub-allocated, so one buffer per upload is cheap
+    auto stagingBuffer = std::make_shared<VkBufferWrap>(m_device,
+                                                        static_cast<int>(size),
+                                                        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    HostBufferController(stagingBuffer).copyToMemory(data, size);
+    return stagingBuffer;
+}
+
+void UploadQueue::retireCompleted(bool wait, UploadTicket ticket) {
+    while (!m_submitted.empty()) {
+        auto& batch = m_submitted.front();
+        if (wait && batch.ticket <= ticket) {
+            m_completionTimeline.wait(batch.timelineValue);
+        } else if (!m_completionTimeline.isComplete(batch.timelineValue)) {
+            break;
+        }
+        
+        m_completedTicket = batch.ticket;
+        batch.stagingBuffers.clear();
+        batch.acquireBufferBarriers.clear();
+        batch.acquireImageBarriers.clear();
+        batch.copyCount = 0;
+        m_freeBatches.push_back(std::move(batch));
+        m_submitted.pop_front();
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class VkDeviceWrap;
+class VkBufferWrap;
+class QueueTimeline;
+
+// Identifies the batch an upload was recorded into, batches complete in order
+using UploadTicket = uint64_t;
+
+/// Records many buffer/image uploads into one command buffer and submits them in one go.
+/// Callers get a ticket and poll or wait on it instead of stalling the queue after every copy,
+/// a ticket resolves to a value on the timeline of the queue retiring the batch.
+/// When the transfer queue belongs to a dedicated family, copies run there and ownership of every
+/// destination is released to the graphics family, which acquires it in a small follow-up submission.
+class UploadQueue {
+public:
+    UploadQueue(const VkDeviceWrap& device,
+                uint32_t transferFamily, QueueTimeline& transferTimeline,
+                uint32_t graphicsFamily, QueueTimeline& graphicsTimeline);
+
+    UploadQueue(const UploadQueue&) = delete;
+    UploadQueue& operator=(const UploadQueue&) = delete;
+
+    ~UploadQueue();
+
+    // Data is copied into staging memory immediately, so the source may be released right after the call
+    UploadTicket uploadBuffer(const void* data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset = 0);
+    // Tightly packed texels for mip 0 / layer 0, the image ends up in finalLayout
+    UploadTicket uploadImage(const void* data,
+                             VkDeviceSize size,
+                             VkImage dstImage,
+                             const VkExtent3D& extent,
+                             VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    UploadTicket copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+
+    // Submits everything recorded so far, returns ticket of the submitted batch
+    UploadTicket flush();
+    bool isComplete(UploadTicket ticket);
+    void wait(UploadTicket ticket);
+    void waitIdle();
+
+    bool transfersOwnership() const { return m_transferFamily != m_graphicsFamily; }
+
+private:
+    struct Batch {
+        UploadTicket ticket = 0;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkCommandBuffer acquireCommandBuffer = VK_NULL_HANDLE; // Graphics side of ownership transfers
+        VkSemaphore transferSemaphore = VK_NULL_HANDLE;
+        uint64_t timelineValue = 0; // Value of m_completionTimeline the whole batch is done at
+        std::vector<std::shared_ptr<VkBufferWrap>> stagingBuffers;
+        std::vector<VkBufferMemoryBarrier> acquireBufferBarriers;
+        std::vector<VkImageMemoryBarrier> acquireImageBarriers;
+        size_t copyCount = 0;
+    };
+
+    const VkDeviceWrap& m_device;
+    uint32_t m_transferFamily;
+    QueueTimeline& m_transferTimeline;
+    uint32_t m_graphicsFamily;
+    QueueTimeline& m_graphicsTimeline;
+    QueueTimeline& m_completionTimeline; // Acquire submissions retire last when ownership is transferred
+    VkCommandPool m_commandPool;
+    VkCommandPool m_acquireCommandPool = VK_NULL_HANDLE;
+    std::mutex m_mutex;
+    Batch m_recording;
+    std::deque<Batch> m_submitted;
+    std::vector<Batch> m_freeBatches;
+    UploadTicket m_completedTicket = 0;
+
+    Batch& recordingBatch();
+    UploadTicket flushRecording();
+    void releaseBuffer(Batch& batch, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size);
+    std::shared_ptr<VkBufferWrap> createStagingBuffer(const void* data, VkDeviceSize size);
+    void retireCompleted(bool wait, UploadTicket ticket);
+};
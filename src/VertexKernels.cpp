@@ -0,0 +1,255 @@
+#include "VertexKernels.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#define VERTEX_KERNELS_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define VERTEX_KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+void transformPointsScalar(const Affine2D& t, const Vec2* in, Vec2* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const Vec2 p = in[i];
+        out[i] = {t.a * p.x + t.c * p.y + t.tx, t.b * p.x + t.d * p.y + t.ty};
+    }
+}
+
+void packVerticesScalar(const Vec2* positions, const Vec3* colors, Vertex* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        out[i].pos = positions[i];
+        out[i].color = colors[i];
+    }
+}
+
+Aabb emptyAabb() {
+    const float inf = std::numeric_limits<float>::infinity();
+    return {{inf, inf}, {-inf, -inf}};
+}
+
+Aabb computeAabbScalar(const Vec2* points, size_t count) {
+    Aabb box = emptyAabb();
+    for (size_t i = 0; i < count; ++i) {
+        box.min.x = std::min(box.min.x, points[i].x);
+        box.min.y = std::min(box.min.y, points[i].y);
+        box.max.x = std::max(box.max.x, points[i].x);
+        box.max.y = std::max(box.max.y, points[i].y);
+    }
+    return box;
+}
+
+Aabb mergeAabb(const Aabb& a, const Aabb& b) {
+    return {{std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y)},
+            {std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y)}};
+}
+
+const VertexKernels SCALAR_KERNELS = {"scalar", transformPointsScalar, packVerticesScalar, computeAabbScalar};
+
+#if VERTEX_KERNELS_X86
+
+// Two points per register as x0 y0 x1 y1, columns of the matrix are broadcast to match
+void transformPointsSse(const Affine2D& t, const Vec2* in, Vec2* out, size_t count) {
+    const __m128 column0 = _mm_setr_ps(t.a, t.b, t.a, t.b);
+    const __m128 column1 = _mm_setr_ps(t.c, t.d, t.c, t.d);
+    const __m128 translation = _mm_setr_ps(t.tx, t.ty, t.tx, t.ty);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const __m128 p = _mm_loadu_ps(&in[i].x);
+        const __m128 x = _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 0, 0));
+        const __m128 y = _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 1, 1));
+        const __m128 result = _mm_add_ps(_mm_add_ps(_mm_mul_ps(column0, x), _mm_mul_ps(column1, y)), translation);
+        _mm_storeu_ps(&out[i].x, result);
+    }
+    transformPointsScalar(t, in + i, out + i, count - i);
+}
+
+// Four vertices (8 position and 12 color floats) are shuffled into five registers of Vertex layout
+void packVerticesSse(const Vec2* positions, const Vec3* colors, Vertex* out, size_t count) {
+    static_assert(sizeof(Vertex) == 5 * sizeof(float), "Vertex must be tightly packed");
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128 p0 = _mm_loadu_ps(&positions[i].x);     // x0 y0 x1 y1
+        const __m128 p1 = _mm_loadu_ps(&positions[i + 2].x); // x2 y2 x3 y3
+        const float* c = &colors[i].x;
+        const __m128 c0 = _mm_loadu_ps(c);                   // r0 g0 b0 r1
+        const __m128 c1 = _mm_loadu_ps(c + 4);               // g1 b1 r2 g2
+        const __m128 c2 = _mm_loadu_ps(c + 8);               // b2 r3 g3 b3
+        
+        const __m128 b0r1x1y1 = _mm_shuffle_ps(c0, p0, _MM_SHUFFLE(3, 2, 3, 2));
+        const __m128 b2b2x3x3 = _mm_shuffle_ps(c2, p1, _MM_SHUFFLE(2, 2, 0, 0));
+        const __m128 y3y3r3r3 = _mm_shuffle_ps(p1, c2, _MM_SHUFFLE(1, 1, 3, 3));
+        
+        float* o = &out[i].pos.x;
+        _mm_storeu_ps(o, _mm_movelh_ps(p0, c0));                                            // x0 y0 r0 g0
+        _mm_storeu_ps(o + 4, _mm_shuffle_ps(b0r1x1y1, b0r1x1y1, _MM_SHUFFLE(1, 3, 2, 0)));  // b0 x1 y1 r1
+        _mm_storeu_ps(o + 8, _mm_movelh_ps(c1, p1));                                        // g1 b1 x2 y2
+        _mm_storeu_ps(o + 12, _mm_shuffle_ps(c1, b2b2x3x3, _MM_SHUFFLE(2, 0, 3, 2)));       // r2 g2 b2 x3
+        _mm_storeu_ps(o + 16, _mm_shuffle_ps(y3y3r3r3, c2, _MM_SHUFFLE(3, 2, 2, 0)));       // y3 r3 g3 b3
+    }
+    packVerticesScalar(positions + i, colors + i, out + i, count - i);
+}
+
+Aabb computeAabbSse(const Vec2* points, size_t count) {
+    if (count < 2)
+        return computeAabbScalar(points, count);
+    
+    __m128 low = _mm_loadu_ps(&points[0].x);
+    __m128 high = low;
+    size_t i = 2;
+    for (; i + 2 <= count; i += 2) {
+        const __m128 p = _mm_loadu_ps(&points[i].x);
+        low = _mm_min_ps(low, p);
+        high = _mm_max_ps(high, p);
+    }
+    // Both halves hold an x y pair
+    low = _mm_min_ps(low, _mm_movehl_ps(low, low));
+    high = _mm_max_ps(high, _mm_movehl_ps(high, high));
+    alignas(16) float lowValues[4];
+    alignas(16) float highValues[4];
+    _mm_store_ps(lowValues, low);
+    _mm_store_ps(highValues, high);
+    const Aabb box = {{lowValues[0], lowValues[1]}, {highValues[0], highValues[1]}};
+    return mergeAabb(box, computeAabbScalar(points + i, count - i));
+}
+
+const VertexKernels SSE_KERNELS = {"sse", transformPointsSse, packVerticesSse, computeAabbSse};
+
+// Compiled for AVX2 regardless of the global flags, only called when the CPU reports support.
+// FMA is left out on purpose, so rounding stays that of the scalar reference. Transforms are only guaranteed
+// to match it within a few ULPs of their largest term, as compilers may still contract either side.
+__attribute__((target("avx2")))
+void transformPointsAvx2(const Affine2D& t, const Vec2* in, Vec2* out, size_t count) {
+    const __m256 column0 = _mm256_setr_ps(t.a, t.b, t.a, t.b, t.a, t.b, t.a, t.b);
+    const __m256 column1 = _mm256_setr_ps(t.c, t.d, t.c, t.d, t.c, t.d, t.c, t.d);
+    const __m256 translation = _mm256_setr_ps(t.tx, t.ty, t.tx, t.ty, t.tx, t.ty, t.tx, t.ty);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m256 p = _mm256_loadu_ps(&in[i].x);
+        const __m256 x = _mm256_moveldup_ps(p);
+        const __m256 y = _mm256_movehdup_ps(p);
+        const __m256 result = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(column0, x), _mm256_mul_ps(column1, y)), translation);
+        _mm256_storeu_ps(&out[i].x, result);
+    }
+    transformPointsScalar(t, in + i, out + i, count - i);
+}
+
+__attribute__((target("avx2")))
+Aabb computeAabbAvx2(const Vec2* points, size_t count) {
+    if (count < 4)
+        return computeAabbSse(points, count);
+    
+    __m256 low = _mm256_loadu_ps(&points[0].x);
+    __m256 high = low;
+    size_t i = 4;
+    for (; i + 4 <= count; i += 4) {
+        const __m256 p = _mm256_loadu_ps(&points[i].x);
+        low = _mm256_min_ps(low, p);
+        high = _mm256_max_ps(high, p);
+    }
+    __m128 low128 = _mm_min_ps(_mm256_castps256_ps128(low), _mm256_extractf128_ps(low, 1));
+    __m128 high128 = _mm_max_ps(_mm256_castps256_ps128(high), _mm256_extractf128_ps(high, 1));
+    low128 = _mm_min_ps(low128, _mm_movehl_ps(low128, low128));
+    high128 = _mm_max_ps(high128, _mm_movehl_ps(high128, high128));
+    alignas(16) float lowValues[4];
+    alignas(16) float highValues[4];
+    _mm_store_ps(lowValues, low128);
+    _mm_store_ps(highValues, high128);
+    const Aabb box = {{lowValues[0], lowValues[1]}, {highValues[0], highValues[1]}};
+    return mergeAabb(box, computeAabbScalar(points + i, count - i));
+}
+
+// Packing is bound by stores, 8 vertex groups would need cross-lane permutes for no gain, so it reuses SSE
+const VertexKernels AVX2_KERNELS = {"avx2", transformPointsAvx2, packVerticesSse, computeAabbAvx2};
+
+#elif VERTEX_KERNELS_NEON
+
+// Structured loads split x and y of four points into separate registers
+void transformPointsNeon(const Affine2D& t, const Vec2* in, Vec2* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const float32x4x2_t p = vld2q_f32(&in[i].x);
+        float32x4x2_t result;
+        result.val[0] = vaddq_f32(vaddq_f32(vmulq_n_f32(p.val[0], t.a), vmulq_n_f32(p.val[1], t.c)), vdupq_n_f32(t.tx));
+        result.val[1] = vaddq_f32(vaddq_f32(vmulq_n_f32(p.val[0], t.b), vmulq_n_f32(p.val[1], t.d)), vdupq_n_f32(t.ty));
+        vst2q_f32(&out[i].x, result);
+    }
+    transformPointsScalar(t, in + i, out + i, count - i);
+}
+
+void packVerticesNeon(const Vec2* positions, const Vec3* colors, Vertex* out, size_t count) {
+    static_assert(sizeof(Vertex) == 5 * sizeof(float), "Vertex must be tightly packed");
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const float32x4_t p0 = vld1q_f32(&positions[i].x);     // x0 y0 x1 y1
+        const float32x4_t p1 = vld1q_f32(&positions[i + 2].x); // x2 y2 x3 y3
+        const float* c = &colors[i].x;
+        const float32x4_t c0 = vld1q_f32(c);                   // r0 g0 b0 r1
+        const float32x4_t c1 = vld1q_f32(c + 4);               // g1 b1 r2 g2
+        const float32x4_t c2 = vld1q_f32(c + 8);               // b2 r3 g3 b3
+        
+        float* o = &out[i].pos.x;
+        vst1q_f32(o, vcombine_f32(vget_low_f32(p0), vget_low_f32(c0)));
+        vst1q_f32(o + 4, vcombine_f32(vzip1_f32(vget_high_f32(c0), vget_high_f32(p0)),
+                                      vzip2_f32(vget_high_f32(p0), vget_high_f32(c0))));
+        vst1q_f32(o + 8, vcombine_f32(vget_low_f32(c1), vget_low_f32(p1)));
+        vst1q_f32(o + 12, vcombine_f32(vget_high_f32(c1), vzip1_f32(vget_low_f32(c2), vget_high_f32(p1))));
+        vst1q_f32(o + 16, vcombine_f32(vzip2_f32(vget_high_f32(p1), vget_low_f32(c2)), vget_high_f32(c2)));
+    }
+    packVerticesScalar(positions + i, colors + i, out + i, count - i);
+}
+
+Aabb computeAabbNeon(const Vec2* points, size_t count) {
+    if (count < 4)
+        return computeAabbScalar(points, count);
+    
+    float32x4x2_t p = vld2q_f32(&points[0].x);
+    float32x4_t lowX = p.val[0];
+    float32x4_t lowY = p.val[1];
+    float32x4_t highX = lowX;
+    float32x4_t highY = lowY;
+    size_t i = 4;
+    for (; i + 4 <= count; i += 4) {
+        p = vld2q_f32(&points[i].x);
+        lowX = vminq_f32(lowX, p.val[0]);
+        lowY = vminq_f32(lowY, p.val[1]);
+        highX = vmaxq_f32(highX, p.val[0]);
+        highY = vmaxq_f32(highY, p.val[1]);
+    }
+    const Aabb box = {{vminvq_f32(lowX), vminvq_f32(lowY)}, {vmaxvq_f32(highX), vmaxvq_f32(highY)}};
+    return mergeAabb(box, computeAabbScalar(points + i, count - i));
+}
+
+const VertexKernels NEON_KERNELS = {"neon", transformPointsNeon, packVerticesNeon, computeAabbNeon};
+
+#endif
+
+} // namespace
+
+const VertexKernels& scalarVertexKernels() {
+    return SCALAR_KERNELS;
+}
+
+std::vector<const VertexKernels*> availableVertexKernels() {
+    std::vector<const VertexKernels*> kernels = {&SCALAR_KERNELS};
+#if VERTEX_KERNELS_X86
+    // SSE2 is part of x86-64, AVX2 depends on the CPU and on OS support for the wide registers
+    kernels.push_back(&SSE_KERNELS);
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        kernels.push_back(&AVX2_KERNELS);
+#elif VERTEX_KERNELS_NEON
+    // Advanced SIMD is mandatory on AArch64
+    kernels.push_back(&NEON_KERNELS);
+#endif
+    return kernels;
+}
+
+const VertexKernels& vertexKernels() {
+    static const VertexKernels& best = *availableVertexKernels().back();
+    return best;
+}
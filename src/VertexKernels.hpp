@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "QuadScene.hpp"
+
+// x' = a * x + c * y + tx, y' = b * x + d * y + ty
+struct Affine2D {
+    float a = 1.0f;
+    float b = 0.0f;
+    float c = 0.0f;
+    float d = 1.0f;
+    float tx = 0.0f;
+    float ty = 0.0f;
+};
+
+struct Aabb {
+    Vec2 min;
+    Vec2 max;
+};
+
+/// One implementation of the bulk vertex operations of the 2D renderer. Arrays need no particular alignment
+/// and any count works, SIMD versions finish the tail with scalar code. in and out of transformPoints may alias.
+struct VertexKernels {
+    const char* name;
+    void (*transformPoints)(const Affine2D& transform, const Vec2* in, Vec2* out, size_t count);
+    // Interleaves positions and colors into Vertex layout, out is typically mapped device memory
+    void (*packVertices)(const Vec2* positions, const Vec3* colors, Vertex* out, size_t count);
+    // min > max for count == 0
+    Aabb (*computeAabb)(const Vec2* points, size_t count);
+};
+
+// Reference implementation, every other set must match it up to float rounding
+const VertexKernels& scalarVertexKernels();
+// Every set the CPU can run, scalar first
+std::vector<const VertexKernels*> availableVertexKernels();
+// Fastest supported set, detected once on first use
+const VertexKernels& vertexKernels();
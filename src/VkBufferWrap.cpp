@@ -1,8 +1,15 @@
 #include "VkBufferWrap.hpp"
 
+#include <algorithm>
+
 #include "VkDeviceWrap.hpp"
+#include "DeletionQueue.hpp"
 
-VkBufferWrap::VkBufferWrap(const VkDeviceWrap& deviceWrap, int size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties)
+VkBufferWrap::VkBufferWrap(const VkDeviceWrap& deviceWrap,
+                           int size,
+                           VkBufferUsageFlags usage,
+                           VkMemoryPropertyFlags properties,
+                           VkDeviceSize minMemoryAlignment)
     : m_deviceWrap(deviceWrap)
 {
     VkBufferCreateInfo bufferInfo = {};
@@ -20,23 +27,23 @@ VkBufferWrap::VkBufferWrap(const VkDeviceWrap& deviceWrap, int size, VkBufferUsa
     
     VkMemoryRequirements memRequirements;
     vkGetBufferMemoryRequirements(m_deviceWrap.device(), buffer, &memRequirements);
+    // Alignments are powers of two, so the larger one satisfies both
+    memRequirements.alignment = std::max(memRequirements.alignment, minMemoryAlignment);
     
-    VkMemoryAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = deviceWrap.physicalDevice().findMemoryType(memRequirements.memoryTypeBits, properties);
-    
-    VkDeviceMemory deviceMemory;
-    if (vkAllocateMemory(m_deviceWrap.device(), &allocInfo, nullptr, &deviceMemory) != VK_SUCCESS)
-        throw std::runtime_error("failed to allocate vertex buffer memory!");
-    m_deviceMemory = deviceMemory;
+    m_allocation = deviceWrap.memoryAllocator().allocate(memRequirements, properties);
     
-    if (vkBindBufferMemory(m_deviceWrap.device(), m_buffer, deviceMemory, 0) != VK_SUCCESS)
+    if (vkBindBufferMemory(m_deviceWrap.device(), m_buffer, m_allocation.deviceMemory, m_allocation.offset) != VK_SUCCESS) {
+        deviceWrap.memoryAllocator().free(m_allocation);
         throw std::runtime_error("Failed to bind vertex buffer!");
+    }
 }
 
 VkBufferWrap::~VkBufferWrap() {
-
-    vkDestroyBuffer(m_deviceWrap.device(), m_buffer, nullptr);
-    vkFreeMemory(m_deviceWrap.device(), m_deviceMemory, nullptr);
+    // Frames still in flight may read the buffer, both go away once they are retired
+    VkDevice device = m_deviceWrap.device();
+    VkMemoryAllocator& allocator = m_deviceWrap.memoryAllocator();
+    m_deviceWrap.deletionQueue().release([device, &allocator, buffer = m_buffer, allocation = m_allocation]() {
+        vkDestroyBuffer(device, buffer, nullptr);
+        allocator.free(allocation);
+    });
 }
@@ -2,24 +2,34 @@
 
 #include <vulkan/vulkan.h>
 
+#include "VkMemoryAllocator.hpp"
+
 class VkDeviceWrap;
 class VkPhysicalDeviceWrap;
 
 class VkBufferWrap {
     friend class VkDeviceWrap; // for construction
 public:
-    VkBufferWrap(const VkDeviceWrap& deviceWrap, int size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
+    // minMemoryAlignment raises the alignment of the memory offset, e.g. to nonCoherentAtomSize for flushed ranges
+    VkBufferWrap(const VkDeviceWrap& deviceWrap,
+                 int size,
+                 VkBufferUsageFlags usage,
+                 VkMemoryPropertyFlags properties,
+                 VkDeviceSize minMemoryAlignment = 0);
     ~VkBufferWrap();
 
     VkBuffer buffer() { return m_buffer; }
     size_t size() { return m_size; }
     const VkDeviceWrap& deviceWrap() { return m_deviceWrap; }
-    VkDeviceMemory deviceMemory() { return m_deviceMemory; }
+    VkDeviceMemory deviceMemory() { return m_allocation.deviceMemory; }
+    VkDeviceSize memoryOffset() { return m_allocation.offset; }
+    void* mappedData() { return m_allocation.mappedData; }
+    uint32_t memoryTypeIndex() { return m_allocation.memoryTypeIndex; }
     
 private:
 
     const VkDeviceWrap& m_deviceWrap;
     VkBuffer m_buffer;
-    VkDeviceMemory m_deviceMemory;
+    MemoryAllocation m_allocation;
     size_t m_size;
 };
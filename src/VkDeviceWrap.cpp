@@ -2,16 +2,21 @@
 
 #include <vulkan/vulkan.hpp>
 
+#include <algorithm>
+#include <cstring>
+
 VkDeviceWrap::VkDeviceWrap(const VkPhysicalDeviceWrap& physicalDevice,
              const VkPhysicalDeviceFeatures& deviceFeatures,
              const std::vector<const char*>& validationLayerNames,
              const std::vector<VkDeviceQueueCreateInfo>& queueCreateInfos,
-             const std::vector<const char*>& extensionNames)
+             const std::vector<const char*>& extensionNames,
+             const void* featureChain)
     : m_physicalDevice(physicalDevice)
 {
     
     VkDeviceCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    createInfo.pNext = featureChain;
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
     createInfo.queueCreateInfoCount = queueCreateInfos.size();
     createInfo.pEnabledFeatures = &deviceFeatures;
@@ -22,9 +27,21 @@ VkDeviceWrap::VkDeviceWrap(const VkPhysicalDeviceWrap& physicalDevice,
     
     if (vkCreateDevice(physicalDevice.physicalDevice(), &createInfo, nullptr, &m_device) != VK_SUCCESS)
         throw std::runtime_error("Failed to create logical device!");
+    
+#ifdef VK_KHR_timeline_semaphore
+    m_timelineSemaphoresEnabled = std::any_of(extensionNames.begin(), extensionNames.end(), [](const char* name) {
+        return std::strcmp(name, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME) == 0;
+    });
+#endif
+    
+    m_memoryAllocator = std::make_unique<VkMemoryAllocator>(m_device, physicalDevice);
+    m_deletionQueue = std::make_unique<DeletionQueue>(m_device);
 }
 
 VkDeviceWrap::~VkDeviceWrap()
 {
+    // Deferred objects give their memory back to the allocator, blocks have to be released while the device is still alive
+    m_deletionQueue.reset();
+    m_memoryAllocator.reset();
     vkDestroyDevice(m_device, nullptr);
 }
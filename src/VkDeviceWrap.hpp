@@ -1,6 +1,10 @@
 #pragma once
 
+#include <memory>
+
 #include "VkPhysicalDeviceWrap.hpp"
+#include "VkMemoryAllocator.hpp"
+#include "DeletionQueue.hpp"
 #include "VkBufferWrap.hpp"
 #include "HostBufferController.hpp"
 
@@ -10,14 +14,22 @@ public:
                  const VkPhysicalDeviceFeatures& deviceFeatures,
                  const std::vector<const char*>& validationLayerNames,
                  const std::vector<VkDeviceQueueCreateInfo>& queueCreateInfos,
-                 const std::vector<const char*>& extensionNames);
+                 const std::vector<const char*>& extensionNames,
+                 const void* featureChain = nullptr);
     
     ~VkDeviceWrap();
     
     VkDevice device() const { return m_device; }
     const VkPhysicalDeviceWrap& physicalDevice() const { return m_physicalDevice; }
+    VkMemoryAllocator& memoryAllocator() const { return *m_memoryAllocator; }
+    DeletionQueue& deletionQueue() const { return *m_deletionQueue; }
+    // VK_KHR_timeline_semaphore was enabled along with its feature
+    bool timelineSemaphoresEnabled() const { return m_timelineSemaphoresEnabled; }
     
 private:
     VkDevice m_device;
     const VkPhysicalDeviceWrap& m_physicalDevice;
+    bool m_timelineSemaphoresEnabled = false;
+    std::unique_ptr<VkMemoryAllocator> m_memoryAllocator;
+    std::unique_ptr<DeletionQueue> m_deletionQueue; // Frees into the allocator
 };
@@ -1,17 +1,25 @@
 #include "VkInstanceWrap.hpp"
 
 #include <exception>
+#include <iostream>
 #include <unordered_set>
 #include <sstream>
 #include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
 
 #include "VulkanUtils.hpp"
 #include "VkPhysicalDeviceWrap.hpp"
+#include "DeviceSelector.hpp"
 #include "VkSurfaceWrap.hpp"
+#include "CpuTracer.hpp"
 
 std::vector<const char*> findMissedExtensionNames(const std::vector<VkExtensionProperties>& avaliableExt,
                                                   const std::vector<const char*>& requiredExtNames)
 {
+    auto less = [](const char* left, const char* right) { return std::strcmp(left, right) < 0; };
+    
     std::vector<const char*> avaliableExtNames(avaliableExt.size());
     std::transform(avaliableExt.begin(),
                    avaliableExt.end(),
@@ -19,40 +27,65 @@ std::vector<const char*> findMissedExtensionNames(const std::vector<VkExtensionP
                    [](const auto& e) {
                        return e.extensionName;
                    } );
+    std::sort(avaliableExtNames.begin(), avaliableExtNames.end(), less);
     
+    // Only the available names are sorted, the missing ones keep the order they were required in
     std::vector<const char*> missing;
-    
-    std::set_difference(requiredExtNames.begin(),
-                        requiredExtNames.end(),
-                        avaliableExtNames.begin(),
-                        avaliableExtNames.end(),
-                        std::back_inserter(missing),
-                        [](const char* required, const char* avaliable){
-                            return std::strcmp(required, avaliable) == 0;
-                        });
+    for (const char* required : requiredExtNames) {
+        if (!std::binary_search(avaliableExtNames.begin(), avaliableExtNames.end(), required, less))
+            missing.push_back(required);
+    }
     return missing;
 }
 
-QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface) {
+QueueFamilyIndices findQueueFamilies(const PhysicalDeviceCapabilities& capabilities, VkSurfaceKHR surface) {
     QueueFamilyIndices indices;
     
-    uint32_t queueFamilyCount = 0;
-    vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
-    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
-    vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
+    const auto& queueFamilies = capabilities.queueFamilies();
+    
+    // Scores prefer families doing as little else as possible, 0 means unusable
+    unsigned transferScore = 0;
+    unsigned computeScore = 0;
     
-    for (unsigned i = 0; i < queueFamilies.size() && !indices.isComplete(); ++i) {
+    for (unsigned i = 0; i < queueFamilies.size(); ++i) {
         const auto& queueFamily = queueFamilies[i];
+        if (queueFamily.queueCount == 0)
+            continue;
         
-        if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+        const bool graphics = queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT;
+        const bool compute = queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT;
+        // Graphics and compute queues support transfer implicitly
+        const bool transfer = graphics || compute || (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT);
+        
+        if (graphics && indices.graphicsFamily == std::numeric_limits<unsigned>::max())
             indices.graphicsFamily = i;
         
-        VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
-        if (queueFamily.queueCount > 0 && presentSupport)
-            indices.presentFamily = i;
+        if (indices.presentFamily == std::numeric_limits<unsigned>::max()) {
+            VkBool32 presentSupport = false;
+            vkGetPhysicalDeviceSurfaceSupportKHR(capabilities.physicalDevice(), i, surface, &presentSupport);
+            if (presentSupport)
+                indices.presentFamily = i;
+        }
+        
+        unsigned score = !transfer ? 0 : !graphics && !compute ? 3 : !graphics ? 2 : 1;
+        if (score > transferScore) {
+            transferScore = score;
+            indices.transferFamily = i;
+        }
+        
+        score = !compute ? 0 : !graphics ? 2 : 1;
+        if (score > computeScore) {
+            computeScore = score;
+            indices.computeFamily = i;
+        }
     }
     
+    // Shared graphics family is the fallback when nothing dedicated exists
+    if (transferScore <= 1)
+        indices.transferFamily = indices.graphicsFamily;
+    if (computeScore <= 1)
+        indices.computeFamily = indices.graphicsFamily;
+    
     return indices;
 }
 
@@ -81,20 +114,6 @@ SwapChainSupportDetails querySwapchainSupport(VkPhysicalDevice device, VkSurface
     return details;
 }
 
-bool isDeviceSuitable(VkPhysicalDevice device, const std::vector<const char*> requiredExtensionNames) {
-    VkPhysicalDeviceProperties deviceProperties;
-    VkPhysicalDeviceFeatures deviceFeatures;
-    vkGetPhysicalDeviceProperties(device, &deviceProperties);
-    vkGetPhysicalDeviceFeatures(device, &deviceFeatures);
-    
-    uint32_t extensionCount;
-    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
-    std::vector<VkExtensionProperties> extensions(extensionCount);
-    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data());
-    
-    return findMissedExtensionNames(extensions, requiredExtensionNames).empty();
-}
-
 std::vector<VkPhysicalDevice> getVkPhysicalDevices(VkInstance instance) {
     uint32_t deviceCount = 0;
     vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
@@ -105,7 +124,8 @@ std::vector<VkPhysicalDevice> getVkPhysicalDevices(VkInstance instance) {
 
 VkInstance createVkInstance(const std::vector<const char*>& requiredExtNames,
                             const std::vector<const char*>& validationLayerNames,
-                            const VkApplicationInfo& appInfo) {
+                            const VkApplicationInfo& appInfo,
+                            const void* pNext) {
 
     auto missing = findMissedExtensionNames(getVkExtensions(), requiredExtNames);
 
@@ -117,6 +137,7 @@ VkInstance createVkInstance(const std::vector<const char*>& requiredExtNames,
     
     VkInstanceCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    createInfo.pNext = pNext;
     createInfo.pApplicationInfo = &appInfo;
     createInfo.enabledExtensionCount = static_cast<uint32_t>(requiredExtNames.size());
     createInfo.ppEnabledExtensionNames = requiredExtNames.data();
@@ -130,62 +151,75 @@ VkInstance createVkInstance(const std::vector<const char*>& requiredExtNames,
 }
 
 VkInstanceWrap::VkInstanceWrap(const std::vector<const char*>& requiredExtensionNames,
-              const std::vector<const char*>& requiredLayerNames,
-              const VkApplicationInfo& appInfo)
+              const std::vector<const char*>& validationLayerNames,
+              const VkApplicationInfo& appInfo,
+              DebugCallback callback)
+    : m_callback(std::move(callback))
 {
-    auto avaliableLayers = getVkValidationLayers();
-    
-    std::vector<const char*> avaliableLayerNames(avaliableLayers.size());
-    std::transform(avaliableLayers.begin(),
-                   avaliableLayers.end(),
-                   avaliableLayerNames.begin(),
-                   [](const auto& e) {
-                       return e.layerName;
-                   } );
-    
-    std::vector<const char*> layerNames;
-    std::set_intersection(requiredLayerNames.begin(),
-                          requiredLayerNames.end(),
-                          avaliableLayerNames.begin(),
-                          avaliableLayerNames.end(),
-                          std::back_inserter(layerNames),
-                          [](const char* required, const char* avaliable) {
-                              return std::strcmp(required, avaliable) == 0;
-                          });
-    
-    auto instance = createVkInstance(requiredExtensionNames, layerNames, appInfo);
+#if TESTAPP_VALIDATION
+    // Validation is off when no layers were asked for, VK_EXT_debug_utils isn't enabled then.
+    // Chained into instance creation, the callback also reports vkCreateInstance and vkDestroyInstance.
+    const auto messengerInfo = debugMessengerCreateInfo(this);
+    const void* pNext = !validationLayerNames.empty() ? &messengerInfo : nullptr;
+#else
+    const void* pNext = nullptr;
+#endif
+    auto instance = createVkInstance(requiredExtensionNames, validationLayerNames, appInfo, pNext);
     m_instance = instance;
 
-    if (!layerNames.empty())
+#if TESTAPP_VALIDATION
+    if (!validationLayerNames.empty())
         m_messenger = createDebugMessenger(instance, this);
+#endif
 }
 
 VkInstanceWrap::~VkInstanceWrap() {
-    vkDestroyInstance(m_instance, nullptr);
-    if (m_messenger != nullptr) {
+#if TESTAPP_VALIDATION
+    // The messenger belongs to the instance, so it goes first
+    if (m_messenger != VK_NULL_HANDLE) {
         auto destroyFunc = vkGetInstanceProcAddr(m_instance, "vkDestroyDebugUtilsMessengerEXT");
         if (destroyFunc != nullptr)
             reinterpret_cast<PFN_vkDestroyDebugUtilsMessengerEXT>(destroyFunc)(m_instance, m_messenger, nullptr);
     }
+#endif
+    vkDestroyInstance(m_instance, nullptr);
 }
 
 VkPhysicalDeviceWrap VkInstanceWrap::findCompatibleDevice(const VkSurfaceWrap& surface,
-                                                          const std::vector<const char*>& requiredExtensions) const
+                                                          const std::vector<const char*>& requiredExtensions,
+                                                          const std::string& gpuOverride) const
 {
+    TRACE_ZONE("findCompatibleDevice");
     auto physicalDevices = getVkPhysicalDevices(m_instance);
     
+    // Captured once, the chosen device keeps its snapshot for the rest of the run
+    std::vector<std::shared_ptr<const PhysicalDeviceCapabilities>> capabilities;
+    std::vector<QueueFamilyIndices> queueFamilies;
+    std::vector<SwapChainSupportDetails> swapchainSupport;
+    std::vector<DeviceCandidate> candidates;
     for (const auto& physicalDevice : physicalDevices) {
-        auto queueFamilies = findQueueFamilies(physicalDevice, surface.surface());
-        auto swapchainSupport = querySwapchainSupport(physicalDevice, surface.surface());
-        if (isDeviceSuitable(physicalDevice, requiredExtensions)
-            && queueFamilies.isComplete()
-            && swapchainSupport.isComplete()) {
-            return VkPhysicalDeviceWrap(physicalDevice, std::move(queueFamilies), std::move(swapchainSupport));
-        }
+        capabilities.push_back(std::make_shared<const PhysicalDeviceCapabilities>(physicalDevice));
+        queueFamilies.push_back(findQueueFamilies(*capabilities.back(), surface.surface()));
+        swapchainSupport.push_back(querySwapchainSupport(physicalDevice, surface.surface()));
+        candidates.push_back(makeDeviceCandidate(*capabilities.back(),
+                                                 queueFamilies.back(),
+                                                 swapchainSupport.back().isComplete(),
+                                                 requiredExtensions));
     }
-    throw std::runtime_error("Failed to find a suitable GPU!");
+    
+    auto selection = selectDevice(candidates, gpuOverride);
+    printDeviceSelection(std::cout, candidates, selection);
+    if (selection.selected == DeviceSelection::NONE)
+        throw std::runtime_error(selection.error);
+    
+    const size_t index = selection.selected;
+    return VkPhysicalDeviceWrap(std::move(capabilities[index]),
+                                std::move(queueFamilies[index]),
+                                std::move(swapchainSupport[index]));
 }
 
+#if TESTAPP_VALIDATION
+
 VKAPI_ATTR VkBool32 VKAPI_CALL VkInstanceWrap::debugCallbackWrap(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
                                                                  VkDebugUtilsMessageTypeFlagsEXT messageType,
                                                                  const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
@@ -197,7 +231,7 @@ VKAPI_ATTR VkBool32 VKAPI_CALL VkInstanceWrap::debugCallbackWrap(VkDebugUtilsMes
     return VK_FALSE;
 }
 
-VkDebugUtilsMessengerEXT VkInstanceWrap::createDebugMessenger(VkInstance instance, VkInstanceWrap* instanceWrap) {
+VkDebugUtilsMessengerCreateInfoEXT VkInstanceWrap::debugMessengerCreateInfo(VkInstanceWrap* instanceWrap) {
     VkDebugUtilsMessengerCreateInfoEXT createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
     createInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT
@@ -208,6 +242,11 @@ VkDebugUtilsMessengerEXT VkInstanceWrap::createDebugMessenger(VkInstance instanc
             | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
     createInfo.pfnUserCallback = VkInstanceWrap::debugCallbackWrap;
     createInfo.pUserData = instanceWrap;
+    return createInfo;
+}
+
+VkDebugUtilsMessengerEXT VkInstanceWrap::createDebugMessenger(VkInstance instance, VkInstanceWrap* instanceWrap) {
+    const auto createInfo = debugMessengerCreateInfo(instanceWrap);
     auto func = (PFN_vkCreateDebugUtilsMessengerEXT) vkGetInstanceProcAddr(instance, "vkCreateDebugUtilsMessengerEXT");
     if (func == nullptr)
         throw std::runtime_error("Can't find CreateDebugUtilsMessengerEXT function");
@@ -216,3 +255,5 @@ VkDebugUtilsMessengerEXT VkInstanceWrap::createDebugMessenger(VkInstance instanc
         throw std::runtime_error("Can't create VkDebugUtilsMessengerEXT");
     return messenger;
 }
+
+#endif
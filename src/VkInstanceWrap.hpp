@@ -3,9 +3,15 @@
 #include <vulkan/vulkan.h>
 #include <vector>
 #include <functional>
+#include <string>
 
 #include "VkPhysicalDeviceWrap.hpp"
 
+// Set by the TESTAPP_VALIDATION CMake option, without it no debug messenger is ever created
+#ifndef TESTAPP_VALIDATION
+#define TESTAPP_VALIDATION 1
+#endif
+
 class VkSurfaceWrap;
 
 class VkInstanceWrap {
@@ -15,9 +21,11 @@ public:
                                              VkDebugUtilsMessageTypeFlagsEXT messageType,
                                              const VkDebugUtilsMessengerCallbackDataEXT& pCallbackData)>;
     
+    // callback is in place before the messenger exists, so it sees messages of everything created from the instance
     VkInstanceWrap(const std::vector<const char*>& requiredExtensionNames,
                   const std::vector<const char*>& validationLayerNames,
-                  const VkApplicationInfo& appInfo);
+                  const VkApplicationInfo& appInfo,
+                  DebugCallback callback = nullptr);
     
     VkInstanceWrap(const VkInstanceWrap&) = delete;
     VkInstanceWrap& operator=(const VkInstanceWrap&) = delete;
@@ -28,20 +36,23 @@ public:
     
     VkInstance instance() const { return m_instance; }
     
-    void setDebugCallback(DebugCallback callback) { m_callback = callback; }
-    
+    // Ranks every device and prints why each was picked or rejected, gpuOverride is described in selectDevice()
     VkPhysicalDeviceWrap findCompatibleDevice (const VkSurfaceWrap& surface,
-                                               const std::vector<const char*>& requiredExtensions) const;
+                                               const std::vector<const char*>& requiredExtensions,
+                                               const std::string& gpuOverride = {}) const;
     
 private:
     VkInstance m_instance;
-    VkDebugUtilsMessengerEXT m_messenger;
+    VkDebugUtilsMessengerEXT m_messenger = VK_NULL_HANDLE;
     DebugCallback m_callback;
     
+#if TESTAPP_VALIDATION
     static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallbackWrap(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
                                                              VkDebugUtilsMessageTypeFlagsEXT messageType,
                                                              const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
                                                              void* pUserData);
+    static VkDebugUtilsMessengerCreateInfoEXT debugMessengerCreateInfo(VkInstanceWrap* instanceWrap);
     static VkDebugUtilsMessengerEXT createDebugMessenger(VkInstance instance, VkInstanceWrap* instanceWrap);
+#endif
 };
 
@@ -0,0 +1,423 @@
+#include "VkMemoryAllocator.hpp"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+#include "VkPhysicalDeviceWrap.hpp"
+
+namespace {
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+VkDeviceSize nextPowerOfTwo(VkDeviceSize value) {
+    VkDeviceSize result = 1;
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+
+struct SubAllocation {
+    VkDeviceSize offset;         // Aligned offset handed out to the user
+    VkDeviceSize reservedOffset; // Start of the range taken from the block
+    VkDeviceSize reservedSize;
+};
+
+class SubAllocator {
+public:
+    virtual ~SubAllocator() = default;
+    virtual bool allocate(VkDeviceSize size, VkDeviceSize alignment, SubAllocation& result) = 0;
+    virtual void free(VkDeviceSize reservedOffset, VkDeviceSize reservedSize) = 0;
+    virtual VkDeviceSize freeBytes() const = 0;
+    virtual VkDeviceSize largestFreeRange() const = 0;
+};
+
+class LinearSubAllocator : public SubAllocator {
+public:
+    explicit LinearSubAllocator(VkDeviceSize capacity) : m_capacity(capacity) {}
+
+    bool allocate(VkDeviceSize size, VkDeviceSize alignment, SubAllocation& result) override {
+        VkDeviceSize offset = alignUp(m_head, alignment);
+        if (offset + size > m_capacity)
+            return false;
+        result = {offset, m_head, offset + size - m_head};
+        m_head = offset + size;
+        ++m_liveCount;
+        return true;
+    }
+
+    void free(VkDeviceSize, VkDeviceSize) override {
+        if (--m_liveCount == 0)
+            m_head = 0;
+    }
+
+    // Freed ranges behind the head can't be reused until the block drains, so only the tail counts
+    VkDeviceSize freeBytes() const override { return m_capacity - m_head; }
+    VkDeviceSize largestFreeRange() const override { return m_capacity - m_head; }
+
+private:
+    VkDeviceSize m_capacity;
+    VkDeviceSize m_head = 0;
+    size_t m_liveCount = 0;
+};
+
+class BuddySubAllocator : public SubAllocator {
+public:
+    static constexpr VkDeviceSize MIN_NODE_SIZE = 256;
+
+    explicit BuddySubAllocator(VkDeviceSize capacity)
+        : m_capacity(capacity)
+        , m_freeBytes(capacity)
+    {
+        unsigned levelCount = 1;
+        for (VkDeviceSize nodeSize = capacity; nodeSize > MIN_NODE_SIZE; nodeSize >>= 1)
+            ++levelCount;
+        m_freeNodes.resize(levelCount);
+        m_freeNodes[0].insert(0);
+    }
+
+    bool allocate(VkDeviceSize size, VkDeviceSize alignment, SubAllocation& result) override {
+        // Nodes are aligned to their own size, so a big enough node satisfies any power of two alignment
+        VkDeviceSize nodeSize = nextPowerOfTwo(std::max({size, alignment, MIN_NODE_SIZE}));
+        if (nodeSize > m_capacity)
+            return false;
+        unsigned level = levelOf(nodeSize);
+
+        int sourceLevel = static_cast<int>(level);
+        while (sourceLevel >= 0 && m_freeNodes[sourceLevel].empty())
+            --sourceLevel;
+        if (sourceLevel < 0)
+            return false;
+
+        VkDeviceSize offset = *m_freeNodes[sourceLevel].begin();
+        m_freeNodes[sourceLevel].erase(m_freeNodes[sourceLevel].begin());
+        // Split down to requested level, right halves go to free lists
+        for (unsigned i = sourceLevel + 1; i <= level; ++i)
+            m_freeNodes[i].insert(offset + (m_capacity >> i));
+
+        m_freeBytes -= nodeSize;
+        result = {offset, offset, nodeSize};
+        return true;
+    }
+
+    void free(VkDeviceSize offset, VkDeviceSize nodeSize) override {
+        m_freeBytes += nodeSize;
+        unsigned level = levelOf(nodeSize);
+        while (level > 0) {
+            VkDeviceSize buddy = offset ^ nodeSize;
+            auto buddyIt = m_freeNodes[level].find(buddy);
+            if (buddyIt == m_freeNodes[level].end())
+                break;
+            m_freeNodes[level].erase(buddyIt);
+            offset = std::min(offset, buddy);
+            nodeSize <<= 1;
+            --level;
+        }
+        m_freeNodes[level].insert(offset);
+    }
+
+    VkDeviceSize freeBytes() const override { return m_freeBytes; }
+
+    VkDeviceSize largestFreeRange() const override {
+        for (unsigned level = 0; level < m_freeNodes.size(); ++level) {
+            if (!m_freeNodes[level].empty())
+                return m_capacity >> level;
+        }
+        return 0;
+    }
+
+private:
+    VkDeviceSize m_capacity;
+    VkDeviceSize m_freeBytes;
+    std::vector<std::set<VkDeviceSize>> m_freeNodes; // Index is level, level 0 is the whole block
+
+    unsigned levelOf(VkDeviceSize nodeSize) const {
+        unsigned level = 0;
+        for (VkDeviceSize size = m_capacity; size > nodeSize; size >>= 1)
+            ++level;
+        return level;
+    }
+};
+
+class FreeListSubAllocator : public SubAllocator {
+public:
+    explicit FreeListSubAllocator(VkDeviceSize capacity)
+        : m_freeBytes(capacity)
+    {
+        m_freeRanges.emplace(0, capacity);
+    }
+
+    bool allocate(VkDeviceSize size, VkDeviceSize alignment, SubAllocation& result) override {
+        for (auto it = m_freeRanges.begin(); it != m_freeRanges.end(); ++it) {
+            VkDeviceSize rangeOffset = it->first;
+            VkDeviceSize rangeSize = it->second;
+            VkDeviceSize offset = alignUp(rangeOffset, alignment);
+            if (offset + size > rangeOffset + rangeSize)
+                continue;
+            // Leading padding stays with the allocation to avoid keeping tiny free ranges around
+            VkDeviceSize reservedSize = offset + size - rangeOffset;
+            m_freeRanges.erase(it);
+            if (reservedSize < rangeSize)
+                m_freeRanges.emplace(rangeOffset + reservedSize, rangeSize - reservedSize);
+            m_freeBytes -= reservedSize;
+            result = {offset, rangeOffset, reservedSize};
+            return true;
+        }
+        return false;
+    }
+
+    void free(VkDeviceSize offset, VkDeviceSize size) override {
+        m_freeBytes += size;
+        auto next = m_freeRanges.lower_bound(offset);
+        if (next != m_freeRanges.end() && offset + size == next->first) {
+            size += next->second;
+            next = m_freeRanges.erase(next);
+        }
+        if (next != m_freeRanges.begin()) {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == offset) {
+                prev->second += size;
+                return;
+            }
+        }
+        m_freeRanges.emplace_hint(next, offset, size);
+    }
+
+    VkDeviceSize freeBytes() const override { return m_freeBytes; }
+
+    VkDeviceSize largestFreeRange() const override {
+        VkDeviceSize largest = 0;
+        for (const auto& range : m_freeRanges)
+            largest = std::max(largest, range.second);
+        return largest;
+    }
+
+private:
+    std::map<VkDeviceSize, VkDeviceSize> m_freeRanges; // offset -> size
+    VkDeviceSize m_freeBytes;
+};
+
+std::unique_ptr<SubAllocator> createSubAllocator(AllocationStrategy strategy, VkDeviceSize capacity) {
+    switch (strategy) {
+        case AllocationStrategy::Linear:
+            return std::make_unique<LinearSubAllocator>(capacity);
+        case AllocationStrategy::Buddy:
+            return std::make_unique<BuddySubAllocator>(capacity);
+        case AllocationStrategy::FreeList:
+            return std::make_unique<FreeListSubAllocator>(capacity);
+    }
+    throw std::runtime_error("Unknown allocation strategy");
+}
+
+} // namespace
+
+class MemoryBlock {
+public:
+    MemoryBlock(VkDeviceMemory deviceMemory, VkDeviceSize size, void* mappedData, AllocationStrategy strategy)
+        : m_deviceMemory(deviceMemory)
+        , m_size(size)
+        , m_mappedData(mappedData)
+        , m_subAllocator(createSubAllocator(strategy, size))
+    {}
+
+    VkDeviceMemory deviceMemory() const { return m_deviceMemory; }
+    VkDeviceSize size() const { return m_size; }
+    void* mappedData() const { return m_mappedData; }
+    size_t allocationCount() const { return m_allocationCount; }
+    VkDeviceSize bytesInUse() const { return m_bytesInUse; }
+    VkDeviceSize bytesReserved() const { return m_bytesReserved; }
+    const SubAllocator& subAllocator() const { return *m_subAllocator; }
+
+    bool allocate(VkDeviceSize size, VkDeviceSize alignment, SubAllocation& result) {
+        if (!m_subAllocator->allocate(size, alignment, result))
+            return false;
+        ++m_allocationCount;
+        m_bytesInUse += size;
+        m_bytesReserved += result.reservedSize;
+        return true;
+    }
+
+    void free(const MemoryAllocation& allocation) {
+        m_subAllocator->free(allocation.reservedOffset, allocation.reservedSize);
+        --m_allocationCount;
+        m_bytesInUse -= allocation.size;
+        m_bytesReserved -= allocation.reservedSize;
+    }
+
+private:
+    VkDeviceMemory m_deviceMemory;
+    VkDeviceSize m_size;
+    void* m_mappedData;
+    std::unique_ptr<SubAllocator> m_subAllocator;
+    size_t m_allocationCount = 0;
+    VkDeviceSize m_bytesInUse = 0;
+    VkDeviceSize m_bytesReserved = 0;
+};
+
+VkMemoryAllocator::VkMemoryAllocator(VkDevice device,
+                                     const VkPhysicalDeviceWrap& physicalDevice,
+                                     VkDeviceSize blockSize,
+                                     AllocationStrategy defaultStrategy)
+    : m_device(device)
+    , m_physicalDevice(physicalDevice)
+    , m_blockSize(nextPowerOfTwo(blockSize))
+    , m_defaultStrategy(defaultStrategy)
+{
+}
+
+VkMemoryAllocator::~VkMemoryAllocator() {
+    for (auto& pool : m_pools) {
+        for (auto& block : pool.blocks)
+            vkFreeMemory(m_device, block->deviceMemory(), nullptr);
+    }
+}
+
+MemoryAllocation VkMemoryAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties) {
+    return allocate(requirements, properties, m_defaultStrategy);
+}
+
+MemoryAllocation VkMemoryAllocator::allocate(const VkMemoryRequirements& requirements,
+                                             VkMemoryPropertyFlags properties,
+                                             AllocationStrategy strategy)
+{
+    // Huge resources would waste most of a block, give them their own memory
+    if (requirements.size > m_blockSize / 2)
+        return allocateDedicated(requirements, properties);
+
+    uint32_t memoryTypeIndex = m_physicalDevice.findMemoryType(requirements.memoryTypeBits, properties);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Pool& pool = findPool(memoryTypeIndex, strategy);
+
+    SubAllocation subAllocation;
+    MemoryBlock* targetBlock = nullptr;
+    for (auto& block : pool.blocks) {
+        if (block->allocate(requirements.size, requirements.alignment, subAllocation)) {
+            targetBlock = block.get();
+            break;
+        }
+    }
+
+    if (targetBlock == nullptr) {
+        void* mappedData = nullptr;
+        VkDeviceMemory deviceMemory = allocateDeviceMemory(m_blockSize, memoryTypeIndex, &mappedData);
+        pool.blocks.push_back(std::make_unique<MemoryBlock>(deviceMemory, m_blockSize, mappedData, strategy));
+        targetBlock = pool.blocks.back().get();
+        if (!targetBlock->allocate(requirements.size, requirements.alignment, subAllocation))
+            throw std::runtime_error("Allocation doesn't fit into an empty memory block!");
+    }
+
+    MemoryAllocation allocation;
+    allocation.deviceMemory = targetBlock->deviceMemory();
+    allocation.offset = subAllocation.offset;
+    allocation.size = requirements.size;
+    allocation.memoryTypeIndex = memoryTypeIndex;
+    if (targetBlock->mappedData() != nullptr)
+        allocation.mappedData = static_cast<char*>(targetBlock->mappedData()) + subAllocation.offset;
+    allocation.block = targetBlock;
+    allocation.reservedOffset = subAllocation.reservedOffset;
+    allocation.reservedSize = subAllocation.reservedSize;
+    return allocation;
+}
+
+MemoryAllocation VkMemoryAllocator::allocateDedicated(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties) {
+    MemoryAllocation allocation;
+    allocation.memoryTypeIndex = m_physicalDevice.findMemoryType(requirements.memoryTypeBits, properties);
+    allocation.deviceMemory = allocateDeviceMemory(requirements.size, allocation.memoryTypeIndex, &allocation.mappedData);
+    allocation.size = requirements.size;
+    allocation.reservedSize = requirements.size;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_dedicatedAllocationCount;
+    m_dedicatedBytes += requirements.size;
+    return allocation;
+}
+
+void VkMemoryAllocator::free(const MemoryAllocation& allocation) {
+    if (allocation.deviceMemory == VK_NULL_HANDLE)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (allocation.block == nullptr) {
+        vkFreeMemory(m_device, allocation.deviceMemory, nullptr);
+        --m_dedicatedAllocationCount;
+        m_dedicatedBytes -= allocation.size;
+        return;
+    }
+
+    allocation.block->free(allocation);
+    if (allocation.block->allocationCount() != 0)
+        return;
+
+    // Keep one empty block per pool to avoid allocation churn, release the rest
+    for (auto& pool : m_pools) {
+        auto it = std::find_if(pool.blocks.begin(), pool.blocks.end(), [&allocation](const auto& block) {
+            return block.get() == allocation.block;
+        });
+        if (it == pool.blocks.end())
+            continue;
+        auto emptyBlocks = std::count_if(pool.blocks.begin(), pool.blocks.end(), [](const auto& block) {
+            return block->allocationCount() == 0;
+        });
+        if (emptyBlocks > 1) {
+            vkFreeMemory(m_device, (*it)->deviceMemory(), nullptr);
+            pool.blocks.erase(it);
+        }
+        return;
+    }
+}
+
+AllocatorStats VkMemoryAllocator::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    AllocatorStats stats;
+    stats.dedicatedAllocationCount = m_dedicatedAllocationCount;
+    stats.allocationCount = m_dedicatedAllocationCount;
+    stats.bytesReserved = m_dedicatedBytes;
+    stats.bytesInUse = m_dedicatedBytes;
+    for (const auto& pool : m_pools) {
+        for (const auto& block : pool.blocks) {
+            ++stats.blockCount;
+            stats.allocationCount += block->allocationCount();
+            stats.bytesReserved += block->size();
+            stats.bytesInUse += block->bytesInUse();
+            stats.bytesWasted += block->bytesReserved() - block->bytesInUse();
+            stats.bytesFree += block->subAllocator().freeBytes();
+            stats.largestFreeRange = std::max(stats.largestFreeRange, block->subAllocator().largestFreeRange());
+        }
+    }
+    return stats;
+}
+
+VkMemoryAllocator::Pool& VkMemoryAllocator::findPool(uint32_t memoryTypeIndex, AllocationStrategy strategy) {
+    for (auto& pool : m_pools) {
+        if (pool.memoryTypeIndex == memoryTypeIndex && pool.strategy == strategy)
+            return pool;
+    }
+    m_pools.push_back(Pool{memoryTypeIndex, strategy, {}});
+    return m_pools.back();
+}
+
+VkDeviceMemory VkMemoryAllocator::allocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, void** mappedData) {
+    VkMemoryAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+    VkDeviceMemory deviceMemory;
+    if (vkAllocateMemory(m_device, &allocInfo, nullptr, &deviceMemory) != VK_SUCCESS)
+        throw std::runtime_error("Failed to allocate device memory!");
+
+    *mappedData = nullptr;
+    if (m_physicalDevice.capabilities().memoryTypeFlags(memoryTypeIndex) & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        if (vkMapMemory(m_device, deviceMemory, 0, VK_WHOLE_SIZE, 0, mappedData) != VK_SUCCESS) {
+            vkFreeMemory(m_device, deviceMemory, nullptr);
+            throw std::runtime_error("Unable to map memory!");
+        }
+    }
+    return deviceMemory;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class VkPhysicalDeviceWrap;
+class MemoryBlock;
+
+enum class AllocationStrategy {
+    Linear,     // Bump pointer, memory is reclaimed when every allocation in the block is freed
+    Buddy,      // Power of two nodes, cheap coalescing, wastes up to half of an allocation
+    FreeList    // First fit over sorted free ranges with neighbour coalescing
+};
+
+struct MemoryAllocation {
+    VkDeviceMemory deviceMemory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    void* mappedData = nullptr; // Not null for host visible memory, already offset
+    uint32_t memoryTypeIndex = 0;
+
+    // Bookkeeping for VkMemoryAllocator::free()
+    MemoryBlock* block = nullptr; // nullptr for dedicated allocations
+    VkDeviceSize reservedOffset = 0;
+    VkDeviceSize reservedSize = 0;
+};
+
+struct AllocatorStats {
+    size_t blockCount = 0;
+    size_t dedicatedAllocationCount = 0;
+    size_t allocationCount = 0;
+    VkDeviceSize bytesReserved = 0;  // Device memory owned by the allocator
+    VkDeviceSize bytesInUse = 0;     // Sum of requested allocation sizes
+    VkDeviceSize bytesWasted = 0;    // Alignment padding and strategy rounding inside live allocations
+    VkDeviceSize bytesFree = 0;
+    VkDeviceSize largestFreeRange = 0;
+
+    // 0 when free space is one contiguous range, close to 1 when it is scattered
+    float fragmentation() const {
+        return bytesFree == 0 ? 0.0f : 1.0f - float(largestFreeRange) / float(bytesFree);
+    }
+};
+
+/// Sub-allocates buffers from large VkDeviceMemory blocks (one pool per memory type and strategy).
+/// Host visible blocks are persistently mapped, so allocations expose mappedData directly.
+class VkMemoryAllocator {
+public:
+    static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64 * 1024 * 1024;
+
+    VkMemoryAllocator(VkDevice device,
+                      const VkPhysicalDeviceWrap& physicalDevice,
+                      VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE,
+                      AllocationStrategy defaultStrategy = AllocationStrategy::FreeList);
+
+    VkMemoryAllocator(const VkMemoryAllocator&) = delete;
+    VkMemoryAllocator& operator=(const VkMemoryAllocator&) = delete;
+
+    ~VkMemoryAllocator();
+
+    MemoryAllocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties);
+    MemoryAllocation allocate(const VkMemoryRequirements& requirements,
+                              VkMemoryPropertyFlags properties,
+                              AllocationStrategy strategy);
+    // One VkDeviceMemory per allocation, the path every buffer used before sub-allocation
+    MemoryAllocation allocateDedicated(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties);
+    void free(const MemoryAllocation& allocation);
+
+    AllocatorStats stats() const;
+    VkDeviceSize blockSize() const { return m_blockSize; }
+    AllocationStrategy defaultStrategy() const { return m_defaultStrategy; }
+
+private:
+    struct Pool {
+        uint32_t memoryTypeIndex;
+        AllocationStrategy strategy;
+        std::vector<std::unique_ptr<MemoryBlock>> blocks;
+    };
+
+    VkDevice m_device;
+    const VkPhysicalDeviceWrap& m_physicalDevice;
+    VkDeviceSize m_blockSize;
+    AllocationStrategy m_defaultStrategy;
+    std::vector<Pool> m_pools;
+    size_t m_dedicatedAllocationCount = 0;
+    VkDeviceSize m_dedicatedBytes = 0;
+    mutable std::mutex m_mutex;
+
+    Pool& findPool(uint32_t memoryTypeIndex, AllocationStrategy strategy);
+    VkDeviceMemory allocateDeviceMemory(VkDeviceSize size, uint32_t memoryTypeIndex, void** mappedData);
+};
@@ -3,20 +3,29 @@
 #include <vulkan/vulkan.h>
 
 #include <limits>
+#include <memory>
 #include <vector>
 #include <unordered_set>
 
+#include "PhysicalDeviceCapabilities.hpp"
+
 struct QueueFamilyIndices {
     unsigned graphicsFamily = std::numeric_limits<unsigned>::max();
     unsigned presentFamily = std::numeric_limits<unsigned>::max();
+    // Fall back to graphicsFamily when the device has no separate family
+    unsigned transferFamily = std::numeric_limits<unsigned>::max();
+    unsigned computeFamily = std::numeric_limits<unsigned>::max();
     
     bool isComplete() const {
         return graphicsFamily != std::numeric_limits<unsigned>::max()
                 && presentFamily != std::numeric_limits<unsigned>::max();
     }
     
+    bool hasDedicatedTransfer() const { return transferFamily != graphicsFamily; }
+    bool hasDedicatedCompute() const { return computeFamily != graphicsFamily; }
+    
     std::vector<unsigned> indices() const {
-        return {graphicsFamily, presentFamily};
+        return {graphicsFamily, presentFamily, transferFamily, computeFamily};
     }
     
     std::unordered_set<unsigned> uniqueIndices() const {
@@ -37,7 +46,7 @@ struct SwapChainSupportDetails {
 
 class VkPhysicalDeviceWrap {
 public:
-    VkPhysicalDeviceWrap(VkPhysicalDevice physicalDevice,
+    VkPhysicalDeviceWrap(std::shared_ptr<const PhysicalDeviceCapabilities> capabilities,
                          QueueFamilyIndices queueFamilies,
                          SwapChainSupportDetails supportDetails);
     
@@ -47,14 +56,16 @@ public:
         // No need to destroy
     }
     
-    const VkPhysicalDevice& physicalDevice() const { return m_physicalDevice; }
+    VkPhysicalDevice physicalDevice() const { return m_capabilities->physicalDevice(); }
+    const PhysicalDeviceCapabilities& capabilities() const { return *m_capabilities; }
     const QueueFamilyIndices& queueFamilies() const { return m_queueFamilies; }
     const SwapChainSupportDetails& supportDetails() const { return m_supportDetails; }
-    VkPhysicalDeviceMemoryProperties getMemoryProperties() const;
+    const VkPhysicalDeviceProperties& getProperties() const { return m_capabilities->properties(); }
+    const VkPhysicalDeviceMemoryProperties& getMemoryProperties() const { return m_capabilities->memoryProperties(); }
     uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
     
 private:
-    VkPhysicalDevice m_physicalDevice;
+    std::shared_ptr<const PhysicalDeviceCapabilities> m_capabilities;
     QueueFamilyIndices m_queueFamilies;
     SwapChainSupportDetails m_supportDetails;
 };
@@ -0,0 +1,103 @@
+#include "VkPipelineCacheWrap.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "VkDeviceWrap.hpp"
+
+namespace {
+
+// Layout of VK_PIPELINE_CACHE_HEADER_VERSION_ONE, see vkGetPipelineCacheData
+struct PipelineCacheHeader {
+    uint32_t headerLength;
+    uint32_t headerVersion;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+};
+
+std::vector<char> readCacheFile(const std::string& path) {
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open())
+        return {};
+    
+    size_t fileSize = (size_t) file.tellg();
+    std::vector<char> buffer(fileSize);
+    file.seekg(0);
+    file.read(buffer.data(), fileSize);
+    return buffer;
+}
+
+bool isCacheCompatible(const std::vector<char>& data, const VkPhysicalDeviceProperties& properties) {
+    PipelineCacheHeader header;
+    if (data.size() < sizeof(header))
+        return false;
+    std::memcpy(&header, data.data(), sizeof(header));
+    return header.headerLength >= sizeof(header)
+        && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+        && header.vendorID == properties.vendorID
+        && header.deviceID == properties.deviceID
+        && std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+} // namespace
+
+VkPipelineCacheWrap::VkPipelineCacheWrap(const VkDeviceWrap& device, std::string path, bool ignoreFile)
+    : m_device(device)
+    , m_path(std::move(path))
+{
+    std::vector<char> initialData;
+    if (!m_path.empty() && !ignoreFile) {
+        initialData = readCacheFile(m_path);
+        if (!initialData.empty() && !isCacheCompatible(initialData, device.physicalDevice().getProperties())) {
+            std::cout << "Pipeline cache " << m_path << " was created by another device or driver, ignoring it" << std::endl;
+            initialData.clear();
+        }
+    }
+    
+    VkPipelineCacheCreateInfo createInfo = {};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = initialData.size();
+    createInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+    
+    if (vkCreatePipelineCache(device.device(), &createInfo, nullptr, &m_pipelineCache) != VK_SUCCESS)
+        throw std::runtime_error("failed to create pipeline cache!");
+    m_warm = !initialData.empty();
+}
+
+VkPipelineCacheWrap::~VkPipelineCacheWrap() {
+    try {
+        save();
+    } catch (const std::exception& e) {
+        std::cout << e.what() << std::endl;
+    }
+    vkDestroyPipelineCache(m_device.device(), m_pipelineCache, nullptr);
+}
+
+void VkPipelineCacheWrap::save() const {
+    if (m_path.empty())
+        return;
+    
+    size_t dataSize = 0;
+    if (vkGetPipelineCacheData(m_device.device(), m_pipelineCache, &dataSize, nullptr) != VK_SUCCESS)
+        throw std::runtime_error("Can't get pipeline cache data size");
+    std::vector<char> data(dataSize);
+    if (vkGetPipelineCacheData(m_device.device(), m_pipelineCache, &dataSize, data.data()) != VK_SUCCESS)
+        throw std::runtime_error("Can't get pipeline cache data");
+    
+    const std::string tempPath = m_path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            throw std::runtime_error("Failed to open file " + tempPath);
+        file.write(data.data(), dataSize);
+        if (!file)
+            throw std::runtime_error("Failed to write file " + tempPath);
+    }
+    if (std::rename(tempPath.c_str(), m_path.c_str()) != 0)
+        throw std::runtime_error("Failed to replace pipeline cache " + m_path);
+}
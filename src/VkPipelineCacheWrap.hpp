@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+
+class VkDeviceWrap;
+
+/// VkPipelineCache persisted between launches. The file is used only when its header matches
+/// the current device (vendor ID, device ID, pipeline cache UUID), otherwise the cache starts empty.
+class VkPipelineCacheWrap {
+public:
+    // Empty path disables persistence, ignoreFile starts cold but still writes the cache back
+    VkPipelineCacheWrap(const VkDeviceWrap& device, std::string path, bool ignoreFile = false);
+
+    VkPipelineCacheWrap(const VkPipelineCacheWrap&) = delete;
+    VkPipelineCacheWrap& operator=(const VkPipelineCacheWrap&) = delete;
+
+    // Writes the cache back to disk
+    ~VkPipelineCacheWrap();
+
+    VkPipelineCache pipelineCache() const { return m_pipelineCache; }
+    // True when the cache was seeded from a valid file
+    bool isWarm() const { return m_warm; }
+
+    // Write to a temporary file and rename it over the old one, so a crash never leaves a torn cache
+    void save() const;
+
+private:
+    const VkDeviceWrap& m_device;
+    std::string m_path;
+    VkPipelineCache m_pipelineCache;
+    bool m_warm = false;
+};
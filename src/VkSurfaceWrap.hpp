@@ -6,7 +6,12 @@ class VkInstanceWrap;
 
 class VkSurfaceWrap {
 public:
-    VkSurfaceWrap(const void* caMetalLayer, const VkInstanceWrap& instance);
+    // Takes ownership of a surface created by the platform layer
+    VkSurfaceWrap(VkSurfaceKHR surface, const VkInstanceWrap& instance);
+    
+    VkSurfaceWrap(const VkSurfaceWrap&) = delete;
+    VkSurfaceWrap& operator=(const VkSurfaceWrap&) = delete;
+    
     ~VkSurfaceWrap();
     VkSurfaceKHR surface() const { return m_surface; }
     
@@ -2,7 +2,10 @@
 #include "VkDeviceWrap.hpp"
 #include "VkSurfaceWrap.hpp"
 
-VkSwapchainWrap::VkSwapchainWrap(const VkDeviceWrap& device, const VkSurfaceWrap& surface, const SwapchainSettings& settings)
+VkSwapchainWrap::VkSwapchainWrap(const VkDeviceWrap& device,
+                                 const VkSurfaceWrap& surface,
+                                 const SwapchainSettings& settings,
+                                 VkSwapchainKHR oldSwapchain)
     : m_device(device)
 {
     VkSwapchainCreateInfoKHR createInfo = {};
@@ -16,7 +19,8 @@ VkSwapchainWrap::VkSwapchainWrap(const VkDeviceWrap& device, const VkSurfaceWrap
     createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
     
     auto queueFamilies = device.physicalDevice().queueFamilies();
-    auto queueFamilyIndices = device.physicalDevice().queueFamilies().indices();
+    // Only queues touching swapchain images need to share them
+    std::vector<unsigned> queueFamilyIndices = {queueFamilies.graphicsFamily, queueFamilies.presentFamily};
     
     if (queueFamilies.graphicsFamily != queueFamilies.presentFamily) {
         createInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
@@ -33,7 +37,7 @@ VkSwapchainWrap::VkSwapchainWrap(const VkDeviceWrap& device, const VkSurfaceWrap
     
     createInfo.presentMode = settings.presentMode;
     createInfo.clipped = VK_TRUE;
-    createInfo.oldSwapchain = VK_NULL_HANDLE;
+    createInfo.oldSwapchain = oldSwapchain;
     
     if (vkCreateSwapchainKHR(device.device(), &createInfo, nullptr, &m_swapchain) != VK_SUCCESS) {
         throw std::runtime_error("failed to create swap chain!");
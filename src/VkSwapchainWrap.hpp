@@ -7,7 +7,7 @@
 struct SwapchainSettings {
     VkSurfaceFormatKHR surfaceFormat;
     VkPresentModeKHR presentMode;
-    const VkExtent2D& extent;
+    VkExtent2D extent;
     uint32_t imageCount;
     VkSurfaceTransformFlagBitsKHR transform;
 };
@@ -17,7 +17,14 @@ class VkSurfaceWrap;
 
 class VkSwapchainWrap {
 public:
-    VkSwapchainWrap(const VkDeviceWrap& device, const VkSurfaceWrap& surface, const SwapchainSettings& settings);
+    // Passing oldSwapchain retires it, images already queued for presentation stay on screen until the handoff
+    VkSwapchainWrap(const VkDeviceWrap& device,
+                    const VkSurfaceWrap& surface,
+                    const SwapchainSettings& settings,
+                    VkSwapchainKHR oldSwapchain = VK_NULL_HANDLE);
+    
+    VkSwapchainWrap(const VkSwapchainWrap&) = delete;
+    VkSwapchainWrap& operator=(const VkSwapchainWrap&) = delete;
     
     ~VkSwapchainWrap();
     
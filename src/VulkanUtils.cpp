@@ -1,5 +1,9 @@
 #include "VulkanUtils.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
 std::vector<VkExtensionProperties> getVkExtensions() {
     uint32_t extensionCount = 0;
     vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
@@ -8,6 +12,13 @@ std::vector<VkExtensionProperties> getVkExtensions() {
     return extensions;
 }
 
+bool instanceExtensionAvailable(const char* extensionName) {
+    auto extensions = getVkExtensions();
+    return std::any_of(extensions.begin(), extensions.end(), [extensionName](const auto& extension) {
+        return strcmp(extension.extensionName, extensionName) == 0;
+    });
+}
+
 std::vector<VkLayerProperties> getVkValidationLayers() {
     uint32_t layerCount;
     vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
@@ -28,3 +39,27 @@ bool validationLayersAvaliable(const std::vector<VkLayerProperties>& validationL
     }
     return true;
 }
+
+std::vector<const char*> findAvailableLayerNames(const std::vector<const char*>& requiredLayerNames) {
+    auto avaliableLayers = getVkValidationLayers();
+    
+    auto less = [](const char* left, const char* right) { return std::strcmp(left, right) < 0; };
+    std::vector<const char*> avaliableLayerNames(avaliableLayers.size());
+    std::transform(avaliableLayers.begin(),
+                   avaliableLayers.end(),
+                   avaliableLayerNames.begin(),
+                   [](const auto& e) {
+                       return e.layerName;
+                   } );
+    std::sort(avaliableLayerNames.begin(), avaliableLayerNames.end(), less);
+    
+    // Layers load in the order they were required in, so only the available names are sorted
+    std::vector<const char*> layerNames;
+    for (const char* required : requiredLayerNames) {
+        if (std::binary_search(avaliableLayerNames.begin(), avaliableLayerNames.end(), required, less))
+            layerNames.push_back(required);
+        else
+            std::cout << "Layer " << required << " isn't available" << std::endl;
+    }
+    return layerNames;
+}
@@ -5,7 +5,12 @@
 
 std::vector<VkExtensionProperties> getVkExtensions();
 
+bool instanceExtensionAvailable(const char* extensionName);
+
 std::vector<VkLayerProperties> getVkValidationLayers();
 
 bool validationLayersAvaliable(const std::vector<VkLayerProperties>& validationLayers,
                                       const std::vector<const char*>& requiredLayerNames);
+
+// Required layers the loader has, in the order they were required in, missing ones are reported on stdout
+std::vector<const char*> findAvailableLayerNames(const std::vector<const char*>& requiredLayerNames);
@@ -10,12 +10,15 @@ extern "C" {
         void* nsWindow;
     } MacOsApp;
 
-    MacOsApp createMacOsApp (void (*updateHandler)(void*));
+    // resizeHandler is called on the main thread after the window changed its size
+    MacOsApp createMacOsApp (void (*updateHandler)(void*), void (*resizeHandler)(void*));
 
     void setUserData(const MacOsApp* macOsApp, void* userDataPtr);
 
     void runMacOsApp(MacOsApp* macOsApp);
 
+    void setMacOsWindowSize(const MacOsApp* macOsApp, unsigned width, unsigned height);
+
 #ifdef __cplusplus
 }
 #endif
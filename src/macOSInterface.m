@@ -9,6 +9,7 @@
 @interface DemoViewController : NSViewController
     @property void *userDataPtr;
     @property void (*updateHandler)();
+    @property void (*resizeHandler)(void*);
     -(void)setUserData: (void*) userData;
 @end
 
@@ -17,9 +18,10 @@
 @end
 
 @interface MyWindowDelegate : NSObject <NSWindowDelegate>
+    @property (weak) DemoViewController* controller;
 @end
 
-MacOsApp createMacOsApp (void (*updateHandler)(void*)) {
+MacOsApp createMacOsApp (void (*updateHandler)(void*), void (*resizeHandler)(void*)) {
     [NSApplication sharedApplication];
     [NSApp setActivationPolicy:NSApplicationActivationPolicyRegular];
     id applicationName = [[NSProcessInfo processInfo] processName];
@@ -32,11 +34,13 @@ MacOsApp createMacOsApp (void (*updateHandler)(void*)) {
     [window cascadeTopLeftFromPoint:NSMakePoint(20,20)];
     [window setTitle: applicationName];
     [window makeKeyAndOrderFront:nil];
-    MyWindowDelegate* windowDelegate = [MyWindowDelegate alloc];
-    [window setDelegate:windowDelegate];
     [NSApp activateIgnoringOtherApps:YES];
     DemoViewController* controller = [[DemoViewController alloc] initWithNibName : nil bundle: nil];
     controller.updateHandler = updateHandler;
+    controller.resizeHandler = resizeHandler;
+    MyWindowDelegate* windowDelegate = [MyWindowDelegate alloc];
+    windowDelegate.controller = controller;
+    [window setDelegate:windowDelegate];
     // Setting contentViewControlelr initiates DemoView creating and [DemoViewController viewDidLoad]
     window.contentViewController = controller;
     // Next lines are executed when DemoView is fully initialized along with CAMetalLayer
@@ -51,6 +55,14 @@ void setUserData(const MacOsApp* macOsApp, void* userDataPtr) {
     [((__bridge DemoViewController*)macOsApp->nsViewController) setUserData : userDataPtr];
 }
 
+void setMacOsWindowSize(const MacOsApp* macOsApp, unsigned width, unsigned height) {
+    NSWindow* window = (__bridge NSWindow*)macOsApp->nsWindow;
+    [window setContentSize:NSMakeSize(width, height)];
+    // Layer size is updated by the next layout pass, force it so the surface reports the new extent
+    [window.contentView layoutSubtreeIfNeeded];
+    [window displayIfNeeded];
+}
+
 // Using of global flags is bad design. But I don't know how to pass an event to
 // following do-while cycle better way and have to time and will to sort this out.
 // I feel like MyWindowDelegate should emit some event about closing the window,
@@ -150,4 +162,10 @@ static CVReturn DisplayLinkCallback(CVDisplayLinkRef displayLink,
     run = false;
 }
 
+- (void)windowDidResize:(NSNotification *)notification {
+    DemoViewController* controller = self.controller;
+    if (controller.resizeHandler != NULL && controller.userDataPtr != NULL)
+        controller.resizeHandler(controller.userDataPtr);
+}
+
 @end
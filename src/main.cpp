@@ -1,771 +1,348 @@
 #include <vulkan/vulkan.h>
-#include <vulkan/vulkan_macos.h>
 #include <iostream>
 #include <stdexcept>
 #include <vector>
-#include <list>
-#include <fstream>
-#include <sstream>
-#include <unordered_set>
-#include <array>
-
-#include "macOSInterface.hpp"
-#include "VulkanUtils.hpp"
-#include "VkInstanceWrap.hpp"
-#include "VkSurfaceWrap.hpp"
-#include "VkDeviceWrap.hpp"
-#include "VkSwapchainWrap.hpp"
-
-struct Vec2 {
-    float x;
-    float y;
-};
-
-struct Vec3 {
-    float x;
-    float y;
-    float z;
-};
-
-struct Vertex {
-    Vec2 pos;
-    Vec3 color;
-    
-    static VkVertexInputBindingDescription getBindingDescription() {
-        VkVertexInputBindingDescription bindingDescription = {};
-        bindingDescription.binding = 0;
-        bindingDescription.stride = sizeof(Vertex);
-        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-        return bindingDescription;
-    }
-    
-    static std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions() {
-        std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions = {};
-        attributeDescriptions[0].binding = 0;
-        attributeDescriptions[0].location = 0;
-        attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
-        attributeDescriptions[0].offset = offsetof(Vertex, pos);
-        attributeDescriptions[1].binding = 0;
-        attributeDescriptions[1].location = 1;
-        attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-        attributeDescriptions[1].offset = offsetof(Vertex, color);
-        return attributeDescriptions;
-    }
-};
-
-const std::vector<Vertex> vertices = {
-    {{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}},
-    {{0.5f, -0.5f}, {0.0f, 1.0f, 0.0f}},
-    {{0.5f, 0.5f}, {0.0f, 0.0f, 1.0f}},
-    {{-0.5f, 0.5f}, {1.0f, 1.0f, 1.0f}}
-};
-
-const std::vector<uint16_t> indices = {
-    0, 1, 2, 2, 3, 0
-};
-
-VkInstanceWrap createVkInstance(const std::vector<const char*>& requiredExtensionNames,
-                            const std::vector<const char*>& validationLayerNames) {
-    std::cout << "available extensions:" << std::endl;
-    for (const auto& extension : getVkExtensions())
-        std::cout << '\t' << extension.extensionName << std::endl;
-    
-    VkApplicationInfo appInfo = {};
-    appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
-    appInfo.pApplicationName = "Hello Triangle";
-    appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.pEngineName = "FlappyEngine";
-    appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion = VK_API_VERSION_1_0;
-
-    return VkInstanceWrap(requiredExtensionNames, validationLayerNames, appInfo);
-}
-
-VkDeviceWrap createVkLogicalDevice(const VkPhysicalDeviceWrap& physicalDevice,
-                               const std::vector<const char*>& validationLayerNames,
-                               const std::vector<const char*>& extensionNames) {
-    // Common for all queues
-    float queuePriority = 1.0f;
-
-    // Queues
-    std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-    for (auto familyIndex : physicalDevice.queueFamilies().uniqueIndices()){
-        VkDeviceQueueCreateInfo& queueCreateInfo = queueCreateInfos.emplace_back();
-        queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-        queueCreateInfo.queueFamilyIndex = familyIndex;
-        queueCreateInfo.queueCount = 1;
-        queueCreateInfo.pQueuePriorities = &queuePriority;
-    }
-    
-    VkPhysicalDeviceFeatures features {};
-
-    return VkDeviceWrap(physicalDevice, features, validationLayerNames, queueCreateInfos, extensionNames);
-}
-
-VkQueue getVkQueue(VkDevice device, unsigned family, unsigned index) {
-    VkQueue queue;
-    vkGetDeviceQueue(device, family, index, &queue);
-    return queue;
-}
-
-VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats) {
-    if (availableFormats.size() == 1 && availableFormats[0].format == VK_FORMAT_UNDEFINED)
-        return {VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR};
-
-    for (const auto& availableFormat : availableFormats) {
-        if (availableFormat.format == VK_FORMAT_B8G8R8A8_UNORM && availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR)
-            return availableFormat;
-    }
-
-    return availableFormats[0];
-}
-
-VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR> availablePresentModes) {
-    VkPresentModeKHR bestMode = VK_PRESENT_MODE_FIFO_KHR;
-
-    for (const auto& availablePresentMode : availablePresentModes) {
-        if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
-            return availablePresentMode;
-        else if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR)
-            bestMode = availablePresentMode;
-    }
-
-    return bestMode;
-}
-
-VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities) {
-    if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
-        return capabilities.currentExtent;
-    } else {
-        VkExtent2D actualExtent = {640, 480};
-
-        actualExtent.width = std::max(capabilities.minImageExtent.width, std::min(capabilities.maxImageExtent.width, actualExtent.width));
-        actualExtent.height = std::max(capabilities.minImageExtent.height, std::min(capabilities.maxImageExtent.height, actualExtent.height));
-
-        return actualExtent;
-    }
-}
-
-uint32_t selectImageCount(const SwapChainSupportDetails& swapChainSupport) {
-    uint32_t imageCount = swapChainSupport.capabilities.minImageCount;
-    // A value of 0 for maxImageCount means that there is no limit besides memory requirements,
-    // which is why we need to check for that.
-    if (swapChainSupport.capabilities.maxImageCount > 0 && imageCount > swapChainSupport.capabilities.maxImageCount) {
-        imageCount = swapChainSupport.capabilities.maxImageCount;
-    }
-
-    return imageCount;
+#include <memory>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <thread>
+#include <string>
+
+#include "RenderContext.hpp"
+#include "Renderer.hpp"
+#include "QuadScene.hpp"
+#include "SpriteBatch.hpp"
+#include "SpriteScene.hpp"
+#include "ParallelRecorder.hpp"
+#include "FrameCommandAllocator.hpp"
+#include "GpuProfiler.hpp"
+#include "CpuTracer.hpp"
+
+void printAllocatorStats(const AllocatorStats& stats) {
+    std::cout << "Device memory: " << stats.blockCount << " blocks, "
+              << stats.dedicatedAllocationCount << " dedicated, "
+              << stats.allocationCount << " allocations, "
+              << stats.bytesInUse << "/" << stats.bytesReserved << " bytes in use, "
+              << stats.bytesWasted << " bytes wasted, "
+              << "fragmentation " << stats.fragmentation() << std::endl;
 }
 
-std::vector<char> readFile(const std::string& filename) {
-    std::ifstream file(filename, std::ios::ate | std::ios::binary);
-
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open file " + filename);
-    }
-
-    size_t fileSize = (size_t) file.tellg();
-    std::vector<char> buffer(fileSize);
-    file.seekg(0);
-    file.read(buffer.data(), fileSize);
-    file.close();
-
-    return buffer;
-}
-
-VkShaderModule createShaderModule(VkDevice device, const std::vector<char>& code) {
-    VkShaderModuleCreateInfo createInfo = {};
-    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = code.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
-    VkShaderModule shaderModule;
-    if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create shader module!");
-    }
-    return shaderModule;
-}
-
-VkPipelineShaderStageCreateInfo prepareStageCreateInfo(VkShaderStageFlagBits stage, VkShaderModule module) {
-    VkPipelineShaderStageCreateInfo vertShaderStageInfo = {};
-    vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    vertShaderStageInfo.stage = stage;
-    vertShaderStageInfo.module = module;
-    vertShaderStageInfo.pName = "main";
-    return vertShaderStageInfo;
-}
-
-VkPipelineLayout createPipelineLayout(VkDevice device) {
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
-    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = 0; // Optional
-    pipelineLayoutInfo.pSetLayouts = nullptr; // Optional
-    pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
-    pipelineLayoutInfo.pPushConstantRanges = nullptr; // Optional
-
-    VkPipelineLayout pipelineLayout;
-    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create pipeline layout!");
-    }
-
-    return pipelineLayout;
-}
-
-VkRenderPass createRenderPass(VkDevice device, VkFormat imageFormat) {
-    VkAttachmentDescription colorAttachment = {};
-    colorAttachment.flags = 0;
-    colorAttachment.format = imageFormat;
-    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-    VkAttachmentReference colorAttachmentRef = {};
-    colorAttachmentRef.attachment = 0;
-    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    VkSubpassDescription subpass = {};
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments = &colorAttachmentRef;
-
-    VkSubpassDependency dependency = {};
-    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-    dependency.dstSubpass = 0;
-    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.srcAccessMask = 0;
-    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-    VkRenderPassCreateInfo renderPassInfo = {};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    renderPassInfo.attachmentCount = 1;
-    renderPassInfo.pAttachments = &colorAttachment;
-    renderPassInfo.subpassCount = 1;
-    renderPassInfo.pSubpasses = &subpass;
-    renderPassInfo.dependencyCount = 1;
-    renderPassInfo.pDependencies = &dependency;
-
-    VkRenderPass renderPass;
-    if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create render pass!");
-    }
-
-    return renderPass;
-}
-
-VkPipeline createGraphicsPipeline(VkDevice device,
-                                  VkPipelineLayout pipelineLayout,
-                                  VkRenderPass renderPass,
-                                  const VkExtent2D& extent)
-{
-
-    VkShaderModule vertShaderModule = createShaderModule(device, readFile("shaders/vert.spv"));
-    VkShaderModule fragShaderModule = createShaderModule(device, readFile("shaders/frag.spv"));
-
-    VkPipelineShaderStageCreateInfo shaderStagesCreateInfo[] = {
-        prepareStageCreateInfo(VK_SHADER_STAGE_VERTEX_BIT, vertShaderModule),
-        prepareStageCreateInfo(VK_SHADER_STAGE_FRAGMENT_BIT, fragShaderModule)
+// Compares allocate/free throughput of sub-allocation against one vkAllocateMemory per buffer
+void benchmarkAllocator(const VkDeviceWrap& device, unsigned allocationCount) {
+    VkMemoryRequirements requirements = {};
+    requirements.alignment = 256;
+    requirements.memoryTypeBits = ~0u;
+    
+    auto measure = [&](const char* name, auto allocateFunc) {
+        std::vector<MemoryAllocation> allocations(allocationCount);
+        auto start = std::chrono::high_resolution_clock::now();
+        for (unsigned i = 0; i < allocationCount; ++i) {
+            requirements.size = 256 + (i % 16) * 1024;
+            allocations[i] = allocateFunc(requirements);
+        }
+        auto allocated = std::chrono::high_resolution_clock::now();
+        for (const auto& allocation : allocations)
+            device.memoryAllocator().free(allocation);
+        auto freed = std::chrono::high_resolution_clock::now();
+        
+        using Microseconds = std::chrono::duration<double, std::micro>;
+        std::cout << name << ": allocate " << Microseconds(allocated - start).count() / allocationCount
+                  << " us, free " << Microseconds(freed - allocated).count() / allocationCount
+                  << " us per allocation" << std::endl;
     };
-
-    auto bindingDescription = Vertex::getBindingDescription();
-    auto attributeDescriptions = Vertex::getAttributeDescriptions();
     
-    VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
-    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertexInputInfo.vertexBindingDescriptionCount = 1;
-    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-    vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
-
-    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
-    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-    inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-    VkViewport viewport = {};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = (float) extent.width;
-    viewport.height = (float) extent.height;
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-
-    VkRect2D scissor = {};
-    scissor.offset = {0, 0};
-    scissor.extent = extent;
-
-    VkPipelineViewportStateCreateInfo viewportState = {};
-    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    viewportState.viewportCount = 1;
-    viewportState.pViewports = &viewport;
-    viewportState.scissorCount = 1;
-    viewportState.pScissors = &scissor;
-
-    VkPipelineRasterizationStateCreateInfo rasterizer = {};
-    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterizer.depthClampEnable = VK_FALSE;
-    rasterizer.rasterizerDiscardEnable = VK_FALSE;
-    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-    rasterizer.lineWidth = 1.0f;
-    rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-    rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
-    rasterizer.depthBiasEnable = VK_FALSE;
-    rasterizer.depthBiasConstantFactor = 0.0f; // Optional
-    rasterizer.depthBiasClamp = 0.0f; // Optional
-    rasterizer.depthBiasSlopeFactor = 0.0f; // Optional
-
-    VkPipelineMultisampleStateCreateInfo multisampling = {};
-    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    multisampling.sampleShadingEnable = VK_FALSE;
-    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-    multisampling.minSampleShading = 1.0f; // Optional
-    multisampling.pSampleMask = nullptr; // Optional
-    multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
-    multisampling.alphaToOneEnable = VK_FALSE; // Optional
-
-    VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
-    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-    colorBlendAttachment.blendEnable = VK_TRUE;
-    colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-    colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-    colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-    colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-    colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-    colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
-
-    VkPipelineColorBlendStateCreateInfo colorBlending = {};
-    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    colorBlending.logicOpEnable = VK_TRUE;
-    colorBlending.logicOp = VK_LOGIC_OP_COPY; // Optional
-    colorBlending.attachmentCount = 1;
-    colorBlending.pAttachments = &colorBlendAttachment;
-    colorBlending.blendConstants[0] = 0.0f; // Optional
-    colorBlending.blendConstants[1] = 0.0f; // Optional
-    colorBlending.blendConstants[2] = 0.0f; // Optional
-    colorBlending.blendConstants[3] = 0.0f; // Optional
-
-    VkDynamicState dynamicStates[] = {
-        VK_DYNAMIC_STATE_VIEWPORT,
-        VK_DYNAMIC_STATE_LINE_WIDTH
-    };
-
-    VkPipelineDynamicStateCreateInfo dynamicState = {};
-    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-    dynamicState.dynamicStateCount = 2;
-    dynamicState.pDynamicStates = dynamicStates;
-
-    VkGraphicsPipelineCreateInfo pipelineInfo = {};
-    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipelineInfo.stageCount = 2;
-    pipelineInfo.pStages = shaderStagesCreateInfo;
-    pipelineInfo.pVertexInputState = &vertexInputInfo;
-    pipelineInfo.pInputAssemblyState = &inputAssembly;
-    pipelineInfo.pViewportState = &viewportState;
-    pipelineInfo.pRasterizationState = &rasterizer;
-    pipelineInfo.pMultisampleState = &multisampling;
-    pipelineInfo.pDepthStencilState = nullptr; // Optional
-    pipelineInfo.pColorBlendState = &colorBlending;
-    pipelineInfo.pDynamicState = nullptr; // Optional
-    pipelineInfo.layout = pipelineLayout;
-    pipelineInfo.renderPass = renderPass;
-    pipelineInfo.subpass = 0;
-    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
-    pipelineInfo.basePipelineIndex = -1; // Optional
-
-    VkPipeline graphicsPipeline;
-
-    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create graphics pipeline!");
-    }
-
-    vkDestroyShaderModule(device, fragShaderModule, nullptr);
-    vkDestroyShaderModule(device, vertShaderModule, nullptr);
-
-    return graphicsPipeline;
-}
-
-std::vector<VkImageView> createSwapchainImageViews( VkDevice logicalDevice,
-                                                    const std::vector<VkImage>& swapchainImages,
-                                                    VkFormat format)
-{
-    std::vector<VkImageView> swapChainImageViews;
-
-    for (auto image: swapchainImages) {
-        VkImageViewCreateInfo createInfo = {};
-        createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-        createInfo.image = image;
-        createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        createInfo.format = format;
-        createInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-        createInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-        createInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-        createInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-        createInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        createInfo.subresourceRange.baseMipLevel = 0;
-        createInfo.subresourceRange.levelCount = 1;
-        createInfo.subresourceRange.baseArrayLayer = 0;
-        createInfo.subresourceRange.layerCount = 1;
-        if (vkCreateImageView(logicalDevice, &createInfo, nullptr, &swapChainImageViews.emplace_back()) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create image views!");
-        }
-    }
-
-    return swapChainImageViews;
+    auto& allocator = device.memoryAllocator();
+    const auto properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    measure("Dedicated", [&](const auto& r) { return allocator.allocateDedicated(r, properties); });
+    measure("Linear", [&](const auto& r) { return allocator.allocate(r, properties, AllocationStrategy::Linear); });
+    measure("Buddy", [&](const auto& r) { return allocator.allocate(r, properties, AllocationStrategy::Buddy); });
+    measure("FreeList", [&](const auto& r) { return allocator.allocate(r, properties, AllocationStrategy::FreeList); });
 }
 
-std::vector<VkFramebuffer> createFramebuffers(VkDevice device,
-                                 VkRenderPass renderPass,
-                                 const std::vector<VkImageView>& imageViewes,
-                                 const VkExtent2D& extent)
-{
-    std::vector<VkFramebuffer> framebuffers;
-    framebuffers.reserve(imageViewes.size());
-
-    for (auto imageView : imageViewes) {
-        VkImageView attachments[] = { imageView };
-
-        VkFramebufferCreateInfo framebufferInfo = {};
-        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        framebufferInfo.renderPass = renderPass;
-        framebufferInfo.attachmentCount = 1;
-        framebufferInfo.pAttachments = attachments;
-        framebufferInfo.width = extent.width;
-        framebufferInfo.height = extent.height;
-        framebufferInfo.layers = 1;
-
-        if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &framebuffers.emplace_back()) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create framebuffer!");
-        }
-    }
-
-    return framebuffers;
-}
-
-VkCommandPool createCommandPool(VkDevice device, const QueueFamilyIndices& queueFamilies) {
-
-    VkCommandPoolCreateInfo poolInfo = {};
-    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    poolInfo.queueFamilyIndex = queueFamilies.graphicsFamily;
-    poolInfo.flags = 0; // Optional
-
-    VkCommandPool commandPool;
-    if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create command pool!");
-    }
-    return commandPool;
-}
-
-std::vector<VkCommandBuffer> createCommandBuffers(VkDevice device,
-                                                  VkCommandPool commandPool,
-                                                  VkRenderPass renderPass,
-                                                  VkPipeline pipeline,
-                                                  const std::vector<VkFramebuffer>& framebuffers,
-                                                  const VkExtent2D& extent,
-                                                  VkBuffer vertexBuffer,
-                                                  VkBuffer indexBuffer) {
-    const size_t frameNumber = framebuffers.size();
-
-    std::vector<VkCommandBuffer> commandBuffers(frameNumber);
-    VkCommandBufferAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = commandPool;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandBufferCount = (uint32_t) commandBuffers.size();
-
-    if (vkAllocateCommandBuffers(device, &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to allocate command buffers!");
+// Resizes the window back and forth and measures how long the swapchain takes to follow
+void stressResize(Platform& platform, SwapchainResources& swapchain, Renderer& renderer, unsigned resizeCount) {
+    std::vector<double> latencies;
+    latencies.reserve(resizeCount);
+    for (unsigned i = 0; i < resizeCount; ++i) {
+        platform.setWindowSize({480 + (i % 8) * 40, 480 + (i % 5) * 40});
+        auto start = std::chrono::high_resolution_clock::now();
+        swapchain.setPreferredExtent(platform.windowExtent());
+        renderer.recreateSwapchain();
+        latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+        // Every new swapchain has to present at least once to take over from the retired one
+        renderer.drawFrame();
     }
+    if (latencies.empty())
+        return;
     
-    for (int i = 0; i < frameNumber; ++i) {
-        VkCommandBufferBeginInfo beginInfo = {};
-        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-        beginInfo.pInheritanceInfo = nullptr; // Optional
-
-        if (vkBeginCommandBuffer(commandBuffers[i], &beginInfo) != VK_SUCCESS) {
-            throw std::runtime_error("failed to begin recording command buffer!");
-        }
+    std::sort(latencies.begin(), latencies.end());
+    double total = 0.0;
+    for (auto latency : latencies)
+        total += latency;
+    std::cout << "Swapchain recreation over " << resizeCount << " resizes: "
+              << "avg " << total / latencies.size() << " ms, "
+              << "median " << latencies[latencies.size() / 2] << " ms, "
+              << "p99 " << latencies[latencies.size() * 99 / 100] << " ms, "
+              << "max " << latencies.back() << " ms" << std::endl;
+}
 
-        VkRenderPassBeginInfo renderPassInfo = {};
-        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderPassInfo.renderPass = renderPass;
-        renderPassInfo.framebuffer = framebuffers[i];
-        renderPassInfo.renderArea.offset = {0, 0};
-        renderPassInfo.renderArea.extent = extent;
-        VkClearValue clearColor;
-        clearColor.color = {{0.0f, 0.0f, 0.0f, 1.0f}};
-        renderPassInfo.clearValueCount = 1;
-        renderPassInfo.pClearValues = &clearColor;
-        vkCmdBeginRenderPass(commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-        vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
-        
-        VkBuffer vertexBuffers[] = {vertexBuffer};
-        VkDeviceSize offsets[] = {0};
-        vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, vertexBuffers, offsets);
-        
-        vkCmdBindIndexBuffer(commandBuffers[i], indexBuffer, 0, VK_INDEX_TYPE_UINT16);
+// Records 100k draws split across secondary command buffers with a growing number of threads
+void benchmarkRecording(const VkDeviceWrap& device,
+                        VkRenderPass renderPass,
+                        VkFramebuffer framebuffer,
+                        const VkExtent2D& extent,
+                        VkPipeline pipeline,
+                        const QuadScene& scene) {
+    const size_t drawCount = 100000;
+    const unsigned iterationCount = 10;
+    const uint32_t graphicsFamily = device.physicalDevice().queueFamilies().graphicsFamily;
+    FrameCommandAllocator primaryAllocator(device, graphicsFamily, 1);
+    
+    // Worker counts, the calling thread always records as well
+    const unsigned hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> workerCounts = {0};
+    for (unsigned workerCount = 1; workerCount < hardwareThreads; workerCount *= 2)
+        workerCounts.push_back(workerCount);
+    if (workerCounts.back() != hardwareThreads - 1)
+        workerCounts.push_back(hardwareThreads - 1);
+    
+    double singleThreadTime = 0.0;
+    for (auto workerCount : workerCounts) {
+        auto jobSystem = workerCount > 0 ? std::make_unique<JobSystem>(workerCount) : nullptr;
+        ParallelRecorder recorder(device, graphicsFamily, 1, jobSystem.get());
+        // A few buffers per thread, so stealing can even out uneven workers
+        const size_t drawsPerBuffer = std::max<size_t>(drawCount / (recorder.threadCount() * 4), 1);
         
-        vkCmdDrawIndexed(commandBuffers[i], static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
-        vkCmdEndRenderPass(commandBuffers[i]);
-        if (vkEndCommandBuffer(commandBuffers[i]) != VK_SUCCESS) {
-            throw std::runtime_error("failed to record command buffer!");
+        std::vector<double> times;
+        for (unsigned i = 0; i < iterationCount; ++i) {
+            primaryAllocator.reset(0);
+            recorder.reset(0);
+            
+            auto start = std::chrono::high_resolution_clock::now();
+            VkCommandBuffer commandBuffer = primaryAllocator.allocate(0);
+            VkCommandBufferBeginInfo beginInfo = {};
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            vkBeginCommandBuffer(commandBuffer, &beginInfo);
+            beginRenderPass(commandBuffer, renderPass, framebuffer, extent, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+            recorder.record(commandBuffer, 0, renderPass, 0, framebuffer, drawCount, drawsPerBuffer,
+                            [&](VkCommandBuffer secondary, size_t begin, size_t end) {
+                scene.record(secondary, pipeline, extent, begin, end, drawCount);
+            });
+            vkCmdEndRenderPass(commandBuffer);
+            vkEndCommandBuffer(commandBuffer);
+            times.push_back(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
         }
+        
+        std::sort(times.begin(), times.end());
+        double medianTime = times[times.size() / 2];
+        if (workerCount == 0)
+            singleThreadTime = medianTime;
+        std::cout << recorder.threadCount() << " recording threads: " << medianTime << " ms for "
+                  << drawCount << " draws, speedup " << singleThreadTime / medianTime << "x" << std::endl;
     }
-
-    return commandBuffers;
-}
-
-void copyBuffer(VkDevice device, VkCommandPool commandPool, VkQueue graphicsQueue, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
-    VkCommandBufferAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandPool = commandPool;
-    allocInfo.commandBufferCount = 1;
-    
-    VkCommandBuffer commandBuffer;
-    vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
-    
-    VkCommandBufferBeginInfo beginInfo = {};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-    
-    vkBeginCommandBuffer(commandBuffer, &beginInfo);
-    
-    VkBufferCopy copyRegion = {};
-    copyRegion.srcOffset = 0; // Optional
-    copyRegion.dstOffset = 0; // Optional
-    copyRegion.size = size;
-    vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
-    
-    vkEndCommandBuffer(commandBuffer);
-    
-    VkSubmitInfo submitInfo = {};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
-    
-    vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(graphicsQueue);
-    
-    vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
-}
-
-VkSemaphore createSemaphore(VkDevice device) {
-    VkSemaphore semaphore;
-    VkSemaphoreCreateInfo semaphoreInfo = {};
-    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-    if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create semaphore!");
-    }
-    return semaphore;
 }
 
-struct UpdateInfo {
-    VkDevice device;
-    VkSwapchainKHR swapchain;
-    std::vector<VkCommandBuffer> commandBuffers;
-    VkSemaphore imageAvailableSemaphore;
-    VkSemaphore renderFinishedSemaphore;
-    VkQueue graphicsQueue;
-    VkQueue presentQueue;
+// Everything platform callbacks need, they may run on a display link thread
+struct AppContext {
+    Platform* platform;
+    SwapchainResources* swapchain;
+    Renderer* renderer;
 };
 
 void update(void* userDataPtr) {
     if (userDataPtr == nullptr)
         return;
-    auto updateInfo = *static_cast<UpdateInfo*>(userDataPtr);
-    
-    uint32_t imageIndex;
-    vkAcquireNextImageKHR(updateInfo.device,
-                          updateInfo.swapchain,
-                          std::numeric_limits<uint64_t>::max(),
-                          updateInfo.imageAvailableSemaphore,
-                          VK_NULL_HANDLE, &imageIndex);
-    VkSubmitInfo submitInfo = {};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-    VkSemaphore waitSemaphores[] = {updateInfo.imageAvailableSemaphore};
-    VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = waitSemaphores;
-    submitInfo.pWaitDstStageMask = waitStages;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &updateInfo.commandBuffers[imageIndex];
-    VkSemaphore signalSemaphores[] = {updateInfo.renderFinishedSemaphore};
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = signalSemaphores;
-    if (vkQueueSubmit(updateInfo.graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
-        throw std::runtime_error("failed to submit draw command buffer!");
-    }
-
-    VkPresentInfoKHR presentInfo = {};
-    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-
-    presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = signalSemaphores;
+    static_cast<AppContext*>(userDataPtr)->renderer->drawFrame();
+}
 
-    VkSwapchainKHR swapChains[] = {updateInfo.swapchain};
-    presentInfo.swapchainCount = 1;
-    presentInfo.pSwapchains = swapChains;
-    presentInfo.pImageIndices = &imageIndex;
-    presentInfo.pResults = nullptr;
-    vkQueuePresentKHR(updateInfo.presentQueue, &presentInfo);
+void resize(void* userDataPtr) {
+    auto& context = *static_cast<AppContext*>(userDataPtr);
+    context.swapchain->setPreferredExtent(context.platform->windowExtent());
+    context.renderer->notifyResized();
 }
 
 int main(int argc, char* argv[]) {
-
-    const std::vector<const char*> requiredValidationLayerNames = {
-        "VK_LAYER_LUNARG_standard_validation",
-        "VK_LAYER_LUNARG_parameter_validation",
-        "VK_LAYER_LUNARG_core_validation",
-        "VK_LAYER_LUNARG_object_tracker",
-        "VK_LAYER_GOOGLE_threading",
-        "VK_LAYER_GOOGLE_unique_objects"
-    };
-
-    auto validationLayers = getVkValidationLayers();
-    std::cout << "Validation layers:" << std::endl;
-    for (auto validationLayer : validationLayers)
-        std::cout << '\t' << validationLayer.layerName << std::endl;
-
-    auto requiredInstanceExtensionNames = std::vector<const char*>{ "VK_KHR_surface", "VK_MVK_macos_surface" };
-    requiredInstanceExtensionNames.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
-    std::cout << "Required extensions for instance:" << std::endl;
-    for (auto requiredExtensionName : requiredInstanceExtensionNames)
-        std::cout << '\t' << requiredExtensionName << std::endl;
-
-    // Create VK instance
-    auto instance = createVkInstance(requiredInstanceExtensionNames, requiredValidationLayerNames);
-    
-    instance.setDebugCallback([](VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
-                                 VkDebugUtilsMessageTypeFlagsEXT messageType,
-                                 const VkDebugUtilsMessengerCallbackDataEXT& pCallbackData) {
-        std::cout << pCallbackData.pMessage << std::endl;
-    });
-    
-    auto macOsApp = createMacOsApp(update);
-
-    VkSurfaceWrap surface(macOsApp.caMetalLayer, instance);
-    
-    const std::vector<const char*> deviceRequiredExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_KHR_SURFACE_EXTENSION_NAME};
-    
-    auto physicalDevice = instance.findCompatibleDevice(surface, deviceRequiredExtensions);
-    
-    std::cout << "Graphics family index: " << physicalDevice.queueFamilies().graphicsFamily << std::endl;
-    std::cout << "Present family index: " << physicalDevice.queueFamilies().presentFamily << std::endl;
-    
-    auto logicalDevice = createVkLogicalDevice(physicalDevice, requiredValidationLayerNames, deviceRequiredExtensions);
-    
-    SwapchainSettings swapchainSettings {
-        .surfaceFormat = chooseSwapSurfaceFormat(physicalDevice.supportDetails().formats),
-        .presentMode = chooseSwapPresentMode(physicalDevice.supportDetails().presentModes),
-        .extent = chooseSwapExtent(physicalDevice.supportDetails().capabilities),
-        .imageCount = selectImageCount(physicalDevice.supportDetails()),
-        .transform = physicalDevice.supportDetails().capabilities.currentTransform
-    };
-    auto swapchain = VkSwapchainWrap(logicalDevice, surface, swapchainSettings);
-    
-    auto swapchainImages = swapchain.getSwapchainImages();
-    
-    auto swapchainImageViews = createSwapchainImageViews(logicalDevice.device(), swapchainImages, swapchainSettings.surfaceFormat.format);
-    
-    auto pipelineLayout = createPipelineLayout(logicalDevice.device());
-    
-    auto renderPass = createRenderPass(logicalDevice.device(), swapchainSettings.surfaceFormat.format);
-    
-    auto framebuffers = createFramebuffers(logicalDevice.device(), renderPass, swapchainImageViews, swapchainSettings.extent);
     
-    auto graphicsPipeline = createGraphicsPipeline(logicalDevice.device(), pipelineLayout, renderPass, swapchainSettings.extent);
-    
-    auto commandPool = createCommandPool(logicalDevice.device(), physicalDevice.queueFamilies());
-    
-    auto graphicsQueue = getVkQueue(logicalDevice.device(), physicalDevice.queueFamilies().graphicsFamily, 0);
-    
-    auto vertexBuffer = std::make_shared<VkBufferWrap>(logicalDevice,
-                                   sizeof(vertices[0]) * vertices.size(),
-                                   VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    
-    HostBufferController(vertexBuffer).copyToMemory(vertices.data(), vertexBuffer->size());
-    
-    auto deviceVertexBuffer = std::make_shared<VkBufferWrap>(logicalDevice,
-                                                       vertexBuffer->size(),
-                                                       VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-                                                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    
-    copyBuffer(logicalDevice.device(),
-               commandPool,
-               graphicsQueue,
-               vertexBuffer->buffer(),
-               deviceVertexBuffer->buffer(),
-               vertexBuffer->size());
-
-    
-    auto indicesBuffer = std::make_shared<VkBufferWrap>(logicalDevice,
-                                                      sizeof(indices[0]) * indices.size(),
-                                                      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                                                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    
-    HostBufferController(indicesBuffer).copyToMemory(indices.data(), indicesBuffer->size());
+    bool benchAllocator = false;
+    unsigned framesInFlight = FrameRing::DEFAULT_FRAMES_IN_FLIGHT;
+    unsigned resizeStressCount = 0;
+    bool parallelRecording = false;
+    bool benchRecording = false;
+    bool gpuProfile = false;
+    size_t quadCount = 1;
+    size_t drawCount = 1;
+    size_t spriteCount = 0;
+    std::string tracePath;
+    RenderContextSettings contextSettings;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--bench-allocator") == 0)
+            benchAllocator = true;
+        else if (std::strcmp(argv[i], "--cold-pipeline-cache") == 0)
+            contextSettings.coldPipelineCache = true;
+        else if (std::strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc)
+            framesInFlight = static_cast<unsigned>(std::stoul(argv[++i]));
+        else if (std::strcmp(argv[i], "--parallel-recording") == 0)
+            parallelRecording = true;
+        else if (std::strcmp(argv[i], "--bench-recording") == 0)
+            benchRecording = true;
+        else if (std::strcmp(argv[i], "--headless") == 0)
+            contextSettings.platform.headless = true;
+        else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            contextSettings.platform.frameLimit = std::stoull(argv[++i]);
+        else if (std::strcmp(argv[i], "--fps") == 0 && i + 1 < argc)
+            contextSettings.platform.targetFps = static_cast<unsigned>(std::stoul(argv[++i]));
+        else if (std::strcmp(argv[i], "--resize-stress") == 0 && i + 1 < argc)
+            resizeStressCount = static_cast<unsigned>(std::stoul(argv[++i]));
+        else if (std::strcmp(argv[i], "--quads") == 0 && i + 1 < argc)
+            quadCount = std::stoull(argv[++i]);
+        else if (std::strcmp(argv[i], "--draws") == 0 && i + 1 < argc)
+            drawCount = std::stoull(argv[++i]);
+        else if (std::strcmp(argv[i], "--validation") == 0)
+            contextSettings.validation = true;
+        else if (std::strcmp(argv[i], "--no-validation") == 0)
+            contextSettings.validation = false;
+        else if (std::strcmp(argv[i], "--sprites") == 0 && i + 1 < argc)
+            spriteCount = std::stoull(argv[++i]);
+        else if (std::strcmp(argv[i], "--gpu") == 0 && i + 1 < argc)
+            contextSettings.gpu = argv[++i];
+        else if (std::strcmp(argv[i], "--gpu-profile") == 0)
+            gpuProfile = true;
+        else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+            tracePath = argv[++i];
+    }
     
-    auto deviceIndicesBuffer = std::make_shared<VkBufferWrap>(logicalDevice,
-                                                             indicesBuffer->size(),
-                                                             VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-                                                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    // Declared first so startup and teardown of everything below end up in the trace
+    CpuTraceSession traceSession(tracePath);
     
-    copyBuffer(logicalDevice.device(),
-               commandPool,
-               graphicsQueue,
-               indicesBuffer->buffer(),
-               deviceIndicesBuffer->buffer(),
-               indicesBuffer->size());
+    RenderContext context(contextSettings, update, resize);
+    const auto& logicalDevice = context.device();
     
-    auto commandBuffers = createCommandBuffers(logicalDevice.device(),
-                                               commandPool, renderPass,
-                                               graphicsPipeline,
-                                               framebuffers,
-                                               swapchainSettings.extent,
-                                               deviceVertexBuffer->buffer(),
-                                               deviceIndicesBuffer->buffer());
+    if (benchAllocator) {
+        // Stays below maxMemoryAllocationCount (4096 on most drivers) for the dedicated path
+        benchmarkAllocator(logicalDevice, 1000);
+        return EXIT_SUCCESS;
+    }
     
-    auto imageAvailableSemaphore = createSemaphore(logicalDevice.device());
-    auto renderFinishedSemaphore = createSemaphore(logicalDevice.device());
+    QuadScene scene(logicalDevice, context.uploadQueue(), quadCount);
+    
+    PipelineDesc pipelineDesc;
+    pipelineDesc.vertexShader = context.shaderLibrary().get("vert.spv")->module();
+    pipelineDesc.fragmentShader = context.shaderLibrary().get("frag.spv")->module();
+    scene.fillPipelineDesc(pipelineDesc);
+    pipelineDesc.layout = context.pipelineLayout();
+    pipelineDesc.renderPass = context.renderPass();
+    
+    auto pipelineStart = std::chrono::high_resolution_clock::now();
+    auto graphicsPipeline = context.pipelineRegistry().get(pipelineDesc);
+    std::cout << "Pipeline creation: "
+              << std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - pipelineStart).count()
+              << " ms (" << (context.pipelineCache().isWarm() ? "warm" : "cold") << " cache)" << std::endl;
+    
+    // Sprites replace the quad grid when asked for
+    std::unique_ptr<StreamingRingBuffer> spriteStream;
+    std::unique_ptr<SpriteBatch> spriteBatch;
+    std::unique_ptr<SpriteScene> spriteScene;
+    VkPipeline spritePipeline = VK_NULL_HANDLE;
+    if (spriteCount > 0) {
+        // Room for every frame in flight plus the one being recorded, and the padding of one wrap
+        spriteStream = std::make_unique<StreamingRingBuffer>(logicalDevice,
+                                                             sizeof(SpriteInstance) * spriteCount * (framesInFlight + 1),
+                                                             VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                                             framesInFlight);
+        spriteBatch = std::make_unique<SpriteBatch>(logicalDevice, context.uploadQueue(), *spriteStream);
+        spriteScene = std::make_unique<SpriteScene>(spriteCount);
+        PipelineDesc spritePipelineDesc = pipelineDesc;
+        spritePipelineDesc.vertexShader = context.shaderLibrary().get("sprite_vert.spv")->module();
+        spritePipelineDesc.fragmentShader = context.shaderLibrary().get("sprite_frag.spv")->module();
+        spriteBatch->fillPipelineDesc(spritePipelineDesc);
+        spritePipeline = context.pipelineRegistry().get(spritePipelineDesc);
+    }
+    const auto startTime = std::chrono::steady_clock::now();
     
-    UpdateInfo updateInfo = UpdateInfo {
-        .device = logicalDevice.device(),
-        .swapchain = swapchain.swapchain(),
-        .commandBuffers = commandBuffers,
-        .imageAvailableSemaphore = imageAvailableSemaphore,
-        .renderFinishedSemaphore = renderFinishedSemaphore,
-        .graphicsQueue = graphicsQueue,
-        .presentQueue = getVkQueue(logicalDevice.device(), physicalDevice.queueFamilies().presentFamily, 0),
-    };
+    printAllocatorStats(logicalDevice.memoryAllocator().stats());
     
-    setUserData(&macOsApp, &updateInfo);
+    auto& swapchain = context.swapchain();
+    const VkRenderPass renderPass = context.renderPass();
     
-    runMacOsApp(&macOsApp);
+    if (benchRecording) {
+        benchmarkRecording(logicalDevice, renderPass, swapchain.framebuffer(0), swapchain.extent(), graphicsPipeline, scene);
+        return EXIT_SUCCESS;
+    }
     
-    setUserData(&macOsApp, nullptr);
-
-    vkDeviceWaitIdle(logicalDevice.device());
-
-    // Vulkan cleanup
-    {
-        vkDestroySemaphore(logicalDevice.device(), renderFinishedSemaphore, nullptr);
-        vkDestroySemaphore(logicalDevice.device(), imageAvailableSemaphore, nullptr);
-        vkDestroyCommandPool(logicalDevice.device(), commandPool, nullptr);
-        for (auto framebuffer : framebuffers) {
-            vkDestroyFramebuffer(logicalDevice.device(), framebuffer, nullptr);
+    // Draw list is split across workers of the job system, each records into its own secondary buffers
+    std::unique_ptr<ParallelRecorder> parallelRecorder;
+    if (parallelRecording)
+        parallelRecorder = std::make_unique<ParallelRecorder>(logicalDevice,
+                                                              logicalDevice.physicalDevice().queueFamilies().graphicsFamily,
+                                                              framesInFlight,
+                                                              &context.jobSystem());
+    
+    std::unique_ptr<GpuProfiler> gpuProfiler;
+    if (gpuProfile) {
+        gpuProfiler = std::make_unique<GpuProfiler>(logicalDevice,
+                                                    logicalDevice.physicalDevice().queueFamilies().graphicsFamily,
+                                                    framesInFlight);
+        if (!gpuProfiler->isEnabled())
+            std::cout << "GPU timestamps are not supported on the graphics queue, --gpu-profile is ignored" << std::endl;
+    }
+    uint64_t recordedFrameCount = 0;
+    
+    auto recordFunc = [&](VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, const VkExtent2D& extent, unsigned frameIndex) {
+        if (gpuProfiler != nullptr) {
+            gpuProfiler->beginFrame(commandBuffer, frameIndex);
+            // Results lag framesInFlight frames behind, print roughly once per second at 60 fps
+            if (++recordedFrameCount % 60 == 0 && gpuProfiler->isEnabled())
+                printGpuTimings(std::cout, *gpuProfiler);
         }
-        vkDestroyRenderPass(logicalDevice.device(), renderPass, nullptr);
-        vkDestroyPipeline(logicalDevice.device(), graphicsPipeline, nullptr);
-        vkDestroyPipelineLayout(logicalDevice.device(), pipelineLayout, nullptr);
-        for (auto imageView : swapchainImageViews) {
-            vkDestroyImageView(logicalDevice.device(), imageView, nullptr);
+        // Timestamps can't be written between secondary buffers, the scope brackets the whole render pass
+        GpuScope scope(gpuProfiler.get(), commandBuffer, "main pass");
+        if (spriteBatch != nullptr) {
+            spriteStream->beginFrame(frameIndex);
+            spriteBatch->begin();
+            spriteScene->update(*spriteBatch, spritePipeline,
+                                std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count());
+            beginRenderPass(commandBuffer, renderPass, framebuffer, extent, VK_SUBPASS_CONTENTS_INLINE);
+            spriteBatch->record(commandBuffer, extent);
+            spriteStream->endFrame();
+        } else if (parallelRecorder != nullptr) {
+            parallelRecorder->reset(frameIndex);
+            beginRenderPass(commandBuffer, renderPass, framebuffer, extent, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+            const size_t drawsPerBuffer = std::max<size_t>(drawCount / (parallelRecorder->threadCount() * 4), 1);
+            parallelRecorder->record(commandBuffer, frameIndex, renderPass, 0, framebuffer, drawCount, drawsPerBuffer,
+                                     [&](VkCommandBuffer secondary, size_t begin, size_t end) {
+                scene.record(secondary, graphicsPipeline, extent, begin, end, drawCount);
+            });
+        } else {
+            beginRenderPass(commandBuffer, renderPass, framebuffer, extent, VK_SUBPASS_CONTENTS_INLINE);
+            scene.record(commandBuffer, graphicsPipeline, extent, 0, drawCount, drawCount);
         }
+        vkCmdEndRenderPass(commandBuffer);
+    };
+    
+    Renderer renderer(logicalDevice,
+                      swapchain,
+                      recordFunc,
+                      framesInFlight,
+                      context.graphicsTimeline(),
+                      context.presentTimeline());
+    
+    // Ownership is acquired on the graphics queue ahead of the first draw, so this only releases staging memory
+    context.uploadQueue().wait(scene.uploadTicket());
+    if (spriteBatch != nullptr)
+        context.uploadQueue().wait(spriteBatch->uploadTicket());
+    
+    auto& platform = context.platform();
+    if (resizeStressCount > 0) {
+        stressResize(platform, swapchain, renderer, resizeStressCount);
+    } else {
+        AppContext appContext {&platform, &swapchain, &renderer};
+        platform.setUserData(&appContext);
+        
+        platform.run();
+        
+        platform.setUserData(nullptr);
     }
 
     return EXIT_SUCCESS;
@@ -0,0 +1,102 @@
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "DeviceSelector.hpp"
+#include "TestCheck.hpp"
+
+namespace {
+
+DeviceCandidate mockDevice(const char* name, VkPhysicalDeviceType type, VkDeviceSize vramMiB, bool dedicatedTransfer) {
+    DeviceCandidate candidate;
+    candidate.name = name;
+    candidate.type = type;
+    candidate.deviceLocalHeapSize = vramMiB << 20;
+    candidate.queueFamilies.graphicsFamily = 0;
+    candidate.queueFamilies.presentFamily = 0;
+    candidate.queueFamilies.transferFamily = dedicatedTransfer ? 1 : 0;
+    candidate.queueFamilies.computeFamily = 0;
+    candidate.swapchainSupported = true;
+    candidate.limits.maxImageDimension2D = 16384;
+    candidate.features.samplerAnisotropy = VK_TRUE;
+    return candidate;
+}
+
+// A dual GPU laptop enumerating the integrated GPU first, next to devices that have to be rejected
+std::vector<DeviceCandidate> dualGpuMachine() {
+    std::vector<DeviceCandidate> candidates = {
+        mockDevice("Intel Iris Xe", VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU, 2048, false),
+        mockDevice("NVIDIA GeForce RTX 3060", VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU, 6144, true),
+        mockDevice("llvmpipe", VK_PHYSICAL_DEVICE_TYPE_CPU, 0, false),
+        mockDevice("Headless Discrete", VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU, 16384, true),
+    };
+    candidates[3].missingExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    return candidates;
+}
+
+void testScoreDevice() {
+    const auto candidates = dualGpuMachine();
+    const auto integrated = scoreDevice(candidates[0]);
+    const auto discrete = scoreDevice(candidates[1]);
+    const auto cpu = scoreDevice(candidates[2]);
+    const auto headless = scoreDevice(candidates[3]);
+    CHECK(integrated.suitable && discrete.suitable && cpu.suitable);
+    CHECK(discrete.score > integrated.score);
+    CHECK(integrated.score > cpu.score);
+    CHECK(!headless.suitable);
+    CHECK(headless.reason.find(VK_KHR_SWAPCHAIN_EXTENSION_NAME) != std::string::npos);
+
+    auto noPresent = candidates[1];
+    noPresent.queueFamilies.presentFamily = std::numeric_limits<unsigned>::max();
+    CHECK(!scoreDevice(noPresent).suitable);
+    auto noSwapchain = candidates[1];
+    noSwapchain.swapchainSupported = false;
+    CHECK(!scoreDevice(noSwapchain).suitable);
+
+    // Memory is capped below the gap between device types
+    auto hugeIntegrated = candidates[0];
+    hugeIntegrated.deviceLocalHeapSize = VkDeviceSize(1) << 40;
+    CHECK(scoreDevice(hugeIntegrated).score < discrete.score);
+}
+
+void testSelectDevice() {
+    const auto candidates = dualGpuMachine();
+    struct Case {
+        std::string gpuOverride;
+        size_t expected;
+    };
+    const std::vector<Case> cases = {
+        {"", 1},
+        {"0", 0},
+        {"iris", 0},
+        {"LLVM", 2},
+        {"3", DeviceSelection::NONE}, // Explicitly picked but rejected
+        {"7", DeviceSelection::NONE},
+        {"radeon", DeviceSelection::NONE},
+    };
+    for (const auto& testCase : cases) {
+        const auto selection = selectDevice(candidates, testCase.gpuOverride);
+        if (selection.selected != testCase.expected) {
+            std::cout << "Override \"" << testCase.gpuOverride << "\" selected " << selection.selected
+                      << ", expected " << testCase.expected << std::endl;
+            printDeviceSelection(std::cout, candidates, selection);
+        }
+        CHECK(selection.selected == testCase.expected);
+        CHECK(selection.scores.size() == candidates.size());
+        if (selection.selected != DeviceSelection::NONE)
+            CHECK(selection.overridden == !testCase.gpuOverride.empty());
+        CHECK(selection.error.empty() == (selection.selected != DeviceSelection::NONE));
+    }
+
+    // Ties go to the earlier candidate
+    const std::vector<DeviceCandidate> twins = {candidates[1], candidates[1]};
+    CHECK(selectDevice(twins, "").selected == 0);
+    CHECK(selectDevice({}, "").selected == DeviceSelection::NONE);
+}
+
+} // namespace
+
+void testDeviceSelector() {
+    testScoreDevice();
+    testSelectDevice();
+}
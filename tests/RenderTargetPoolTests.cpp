@@ -0,0 +1,82 @@
+#include <utility>
+#include <vector>
+
+#include "RenderTargetPool.hpp"
+#include "TestCheck.hpp"
+
+namespace {
+
+AliasedRange range(VkDeviceSize size, VkDeviceSize alignment, std::vector<RenderTargetLifetime> lifetimes) {
+    AliasedRange result;
+    result.size = size;
+    result.alignment = alignment;
+    result.lifetimes = std::move(lifetimes);
+    return result;
+}
+
+bool intersects(const AliasedRange& a, const AliasedRange& b) {
+    return a.offset < b.offset + b.size && b.offset < a.offset + a.size;
+}
+
+// Ranges alive at the same time must never share memory, every offset must keep its alignment
+void checkPlan(const std::vector<AliasedRange*>& ranges, VkDeviceSize peak) {
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        CHECK(ranges[i]->offset % ranges[i]->alignment == 0);
+        CHECK(ranges[i]->offset + ranges[i]->size <= peak);
+        for (size_t j = i + 1; j < ranges.size(); ++j)
+            CHECK(!(ranges[i]->overlaps(*ranges[j]) && intersects(*ranges[i], *ranges[j])));
+    }
+}
+
+} // namespace
+
+void testRenderTargetAliasing() {
+    CHECK((RenderTargetLifetime {0, 1}).overlaps({1, 2}));
+    CHECK(!(RenderTargetLifetime {0, 1}).overlaps({2, 3}));
+    CHECK(planAliasing({}) == 0);
+
+    // Passes of a deferred frame with bloom: 0 gbuffer, 1 lighting, 2 bloom downsample, 3 bloom blur,
+    // 4 bloom composite, 5 tonemap. Sizes of a 1080p frame.
+    const VkDeviceSize rgba8 = 1920 * 1080 * 4;
+    const VkDeviceSize rgba16 = 1920 * 1080 * 8;
+    const VkDeviceSize halfRgba16 = rgba16 / 4;
+    AliasedRange albedo = range(rgba8, 4096, {{0, 1}});
+    AliasedRange normals = range(rgba16, 4096, {{0, 1}});
+    AliasedRange depth = range(1920 * 1080 * 2, 4096, {{0, 1}});
+    AliasedRange hdr = range(rgba16, 4096, {{1, 5}});
+    AliasedRange bloom = range(halfRgba16, 4096, {{2, 3}, {4, 5}}); // Downsample and composite share an image
+    AliasedRange blur = range(halfRgba16, 4096, {{3, 4}});
+    const std::vector<AliasedRange*> frame = {&albedo, &normals, &depth, &hdr, &bloom, &blur};
+    const VkDeviceSize peak = planAliasing(frame);
+    checkPlan(frame, peak);
+
+    VkDeviceSize naive = 0;
+    for (const auto* aliased : frame)
+        naive += aliased->size;
+    CHECK(peak < naive);
+    // The G-buffer is dead once lighting ends, bloom fits into its memory next to the HDR target
+    CHECK(peak <= albedo.size + normals.size + depth.size + hdr.size);
+    CHECK(intersects(bloom, normals) || intersects(bloom, albedo) || intersects(bloom, depth));
+
+    // Alignment of a range is kept after an odd sized neighbour
+    AliasedRange odd = range(1000, 1, {{0, 0}});
+    AliasedRange aligned = range(4096, 256, {{0, 0}});
+    AliasedRange later = range(4096, 256, {{1, 1}});
+    const std::vector<AliasedRange*> packed = {&odd, &aligned, &later};
+    const VkDeviceSize packedPeak = planAliasing(packed);
+    checkPlan(packed, packedPeak);
+    CHECK(later.offset == 0);
+    CHECK(packedPeak == 4096 + 1000);
+
+    // A gap left between two live ranges is reused when the next one fits in
+    AliasedRange first = range(100, 1, {{0, 0}});
+    AliasedRange second = range(60, 1, {{1, 1}});
+    AliasedRange spanning = range(50, 1, {{0, 1}});
+    AliasedRange fits = range(40, 1, {{1, 1}});
+    const std::vector<AliasedRange*> gap = {&first, &second, &spanning, &fits};
+    const VkDeviceSize gapPeak = planAliasing(gap);
+    checkPlan(gap, gapPeak);
+    CHECK(spanning.offset == 100);
+    CHECK(fits.offset == 60);
+    CHECK(gapPeak == 150);
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <iostream>
+
+// Failed checks of the running suite, a failed check reports itself and the suite goes on
+extern unsigned g_failedCheckCount;
+
+#define CHECK(condition)                                                                          \
+    do {                                                                                          \
+        if (!(condition)) {                                                                       \
+            std::cout << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+            ++g_failedCheckCount;                                                                 \
+        }                                                                                         \
+    } while (false)
+
+void testDeviceSelector();
+void testVertexKernels();
+void testRenderTargetAliasing();
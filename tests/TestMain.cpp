@@ -0,0 +1,53 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+
+#include "TestCheck.hpp"
+
+unsigned g_failedCheckCount = 0;
+
+namespace {
+
+struct Suite {
+    const char* name;
+    void (*run)();
+};
+
+// Registered with CTest one by one, see CMakeLists.txt
+const Suite suites[] = {
+    {"DeviceSelector", testDeviceSelector},
+    {"VertexKernels", testVertexKernels},
+    {"RenderTargetAliasing", testRenderTargetAliasing},
+};
+
+bool runSuite(const Suite& suite) {
+    g_failedCheckCount = 0;
+    suite.run();
+    std::cout << suite.name << ": " << (g_failedCheckCount == 0 ? "passed" : "failed") << std::endl;
+    return g_failedCheckCount == 0;
+}
+
+} // namespace
+
+// Runs the suites named on the command line, or all of them. No GPU is needed.
+int main(int argc, char* argv[]) {
+    bool allPassed = true;
+    if (argc < 2) {
+        for (const auto& suite : suites)
+            allPassed = runSuite(suite) && allPassed;
+    }
+    for (int i = 1; i < argc; ++i) {
+        const auto suiteIt = std::find_if(std::begin(suites), std::end(suites), [&](const Suite& suite) {
+            return std::strcmp(suite.name, argv[i]) == 0;
+        });
+        if (suiteIt == std::end(suites)) {
+            std::cout << "Unknown suite " << argv[i] << std::endl;
+            allPassed = false;
+            continue;
+        }
+        allPassed = runSuite(*suiteIt) && allPassed;
+    }
+    return allPassed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "VertexKernels.hpp"
+#include "TestCheck.hpp"
+
+namespace {
+
+// A few ULPs of the largest term that went into the values, so results cancelling out to almost zero
+// still compare equal. Equal infinities (boxes of no points) compare equal as well.
+bool nearlyEqual(float a, float b, float magnitude) {
+    if (a == b)
+        return true;
+    const float scale = std::max({magnitude, std::fabs(a), std::fabs(b)});
+    return std::fabs(a - b) <= 4.0f * std::numeric_limits<float>::epsilon() * scale;
+}
+
+// memcmp must not see the null data() of empty vectors
+bool sameBytes(const void* a, const void* b, size_t size) {
+    return size == 0 || std::memcmp(a, b, size) == 0;
+}
+
+} // namespace
+
+// Every kernel set has to reproduce the scalar reference, including the scalar tails of odd counts
+void testVertexKernels() {
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> distribution(-100.0f, 100.0f);
+    const Affine2D transform {0.8f, -0.6f, 0.6f, 0.8f, 12.5f, -3.25f};
+    const auto& reference = scalarVertexKernels();
+    const auto kernelSets = availableVertexKernels();
+    CHECK(!kernelSets.empty() && kernelSets.front() == &reference);
+
+    for (size_t count : {0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 1023}) {
+        std::vector<Vec2> points(count);
+        std::vector<Vec3> colors(count);
+        for (auto& point : points)
+            point = {distribution(random), distribution(random)};
+        for (auto& color : colors)
+            color = {distribution(random), distribution(random), distribution(random)};
+
+        std::vector<Vec2> expectedPoints(count);
+        std::vector<Vertex> expectedVertices(count);
+        reference.transformPoints(transform, points.data(), expectedPoints.data(), count);
+        reference.packVertices(points.data(), colors.data(), expectedVertices.data(), count);
+        const Aabb expectedBox = reference.computeAabb(points.data(), count);
+        if (count == 0)
+            CHECK(expectedBox.min.x > expectedBox.max.x && expectedBox.min.y > expectedBox.max.y);
+
+        for (const auto* kernels : kernelSets) {
+            std::vector<Vec2> transformed(count);
+            std::vector<Vertex> vertices(count);
+            kernels->transformPoints(transform, points.data(), transformed.data(), count);
+            kernels->packVertices(points.data(), colors.data(), vertices.data(), count);
+            const Aabb box = kernels->computeAabb(points.data(), count);
+            // Packing only moves floats, so it has to be bit identical. Transforms may round differently where
+            // a compiler fuses the reference into FMA, and SIMD min/max may pick the other zero of +0/-0.
+            bool kernelsEqual = sameBytes(vertices.data(), expectedVertices.data(), sizeof(Vertex) * count)
+                && nearlyEqual(box.min.x, expectedBox.min.x, 0.0f) && nearlyEqual(box.min.y, expectedBox.min.y, 0.0f)
+                && nearlyEqual(box.max.x, expectedBox.max.x, 0.0f) && nearlyEqual(box.max.y, expectedBox.max.y, 0.0f);
+            for (size_t i = 0; i < count; ++i) {
+                const Vec2& p = points[i];
+                const float magnitudeX = std::fabs(transform.a * p.x) + std::fabs(transform.c * p.y) + std::fabs(transform.tx);
+                const float magnitudeY = std::fabs(transform.b * p.x) + std::fabs(transform.d * p.y) + std::fabs(transform.ty);
+                kernelsEqual = kernelsEqual && nearlyEqual(transformed[i].x, expectedPoints[i].x, magnitudeX)
+                    && nearlyEqual(transformed[i].y, expectedPoints[i].y, magnitudeY);
+            }
+            if (!kernelsEqual)
+                std::cout << kernels->name << " kernels differ from scalar for " << count << " points" << std::endl;
+            CHECK(kernelsEqual);
+
+            // Transforming in place is allowed
+            std::vector<Vec2> inPlace = points;
+            kernels->transformPoints(transform, inPlace.data(), inPlace.data(), count);
+            CHECK(sameBytes(inPlace.data(), transformed.data(), sizeof(Vec2) * count));
+        }
+    }
+}